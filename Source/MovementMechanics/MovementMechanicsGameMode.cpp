@@ -3,6 +3,7 @@
 #include "MovementMechanicsGameMode.h"
 #include "MovementMechanicsCharacter.h"
 #include "UObject/ConstructorHelpers.h"
+#include "VisualLogger/VisualLogger.h"
 
 AMovementMechanicsGameMode::AMovementMechanicsGameMode()
 	: Super()
@@ -12,3 +13,16 @@ AMovementMechanicsGameMode::AMovementMechanicsGameMode()
 	DefaultPawnClass = PlayerPawnClassFinder.Class;
 
 }
+
+void AMovementMechanicsGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+#if ENABLE_VISUAL_LOG
+	// written to Saved/Logs as a .bvlog when the recording stops, open it in the Visual Logger tab
+	if (FParse::Param(FCommandLine::Get(), TEXT("MovementVisLog")))
+	{
+		FVisualLogger::Get().SetIsRecording(true);
+		FVisualLogger::Get().SetIsRecordingToFile(true);
+	}
+#endif
+}
@@ -13,6 +13,9 @@ class AMovementMechanicsGameMode : public AGameModeBase
 
 public:
 	AMovementMechanicsGameMode();
+
+	// -MovementVisLog records the visual log to a file from the start, for headless servers
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
 };
 
 
@@ -31,6 +31,32 @@ AMovementMechanicsProjectile::AMovementMechanicsProjectile()
 	InitialLifeSpan = 3.0f;
 }
 
+void AMovementMechanicsProjectile::BeginPlay()
+{
+	// the life span, possibly overridden in a blueprint, goes on the timer wheel instead of an actor timer
+	UMovementTimerSubsystem* timers = GetWorld()->GetSubsystem<UMovementTimerSubsystem>();
+	const float lifeSpan = InitialLifeSpan;
+	if (timers && lifeSpan > 0.0f)
+		InitialLifeSpan = 0.0f;
+
+	Super::BeginPlay();
+
+	if (timers && lifeSpan > 0.0f)
+		LifeTimer = timers->Schedule(lifeSpan, FMovementTimerCallback::Create<AMovementMechanicsProjectile, &AMovementMechanicsProjectile::OnLifeExpired>(this));
+}
+
+void AMovementMechanicsProjectile::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UMovementTimerSubsystem* timers = GetWorld()->GetSubsystem<UMovementTimerSubsystem>())
+		timers->Cancel(LifeTimer);
+	Super::EndPlay(EndPlayReason);
+}
+
+void AMovementMechanicsProjectile::OnLifeExpired()
+{
+	Destroy();
+}
+
 void AMovementMechanicsProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
 	// Only add impulse and destroy projectile if we hit a physics
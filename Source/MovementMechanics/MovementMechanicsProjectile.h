@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "MovementTimerSubsystem.h"
 #include "MovementMechanicsProjectile.generated.h"
 
 class USphereComponent;
@@ -22,9 +23,17 @@ class AMovementMechanicsProjectile : public AActor
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
 	UProjectileMovementComponent* ProjectileMovement;
 
+	/** Handle of the timer that destroys the projectile at the end of its life, InitialLifeSpan is scheduled on the world timer wheel */
+	FMovementTimerHandle LifeTimer;
+
+	void OnLifeExpired();
+
 public:
 	AMovementMechanicsProjectile();
 
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/** called when projectile hits something */
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
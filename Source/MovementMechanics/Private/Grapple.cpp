@@ -6,8 +6,8 @@
 // Sets default values
 AGrapple::AGrapple()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// the max distance is a scheduled timer, nothing to do every frame
+	PrimaryActorTick.bCanEverTick = false;
 	
 	if (!RootComponent)
 	{
@@ -49,15 +49,101 @@ void AGrapple::BeginPlay()
 	ProjectileMovement->Velocity = Velocity;
 	StartLocation = GetActorLocation();;
 	//CollisionComponent->OnComponentHit.AddDynamic(this, &AGrapple::OnCompHit);
+	ProjectileMovement->OnProjectileStop.AddDynamic(this, &AGrapple::OnHookStopped);
 }
 
-// Called every frame
-void AGrapple::Tick(float DeltaTime)
+void AGrapple::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
-	if (UKismetMathLibrary::Vector_Distance(StartLocation, GetActorLocation()) >= MaxDistance)
+	CancelExpiry();
+	Super::EndPlay(EndPlayReason);
+}
+
+void AGrapple::ScheduleExpiry(float Distance, const FVector& FlightVelocity)
+{
+	CancelExpiry();
+	UMovementTimerSubsystem* timers = GetWorld()->GetSubsystem<UMovementTimerSubsystem>();
+	// the movement component clamps the velocity to its max speed
+	float speed = FlightVelocity.Size();
+	if (ProjectileMovement->GetMaxSpeed() > 0.0f)
+		speed = FMath::Min(speed, ProjectileMovement->GetMaxSpeed());
+	if (timers && speed > KINDA_SMALL_NUMBER)
+		ExpiryTimer = timers->Schedule(FMath::Max(Distance, 0.0f) / speed, FMovementTimerCallback::Create<AGrapple, &AGrapple::Release>(this));
+}
+
+void AGrapple::CancelExpiry()
+{
+	if (!ExpiryTimer.IsValid())
+		return;
+	if (UMovementTimerSubsystem* timers = GetWorld() ? GetWorld()->GetSubsystem<UMovementTimerSubsystem>() : nullptr)
+		timers->Cancel(ExpiryTimer);
+	ExpiryTimer.Invalidate();
+}
+
+void AGrapple::OnHookStopped(const FHitResult& ImpactResult)
+{
+	// attached, it stays until the owner detaches it
+	CancelExpiry();
+}
+
+void AGrapple::Launch(const FVector& Location, const FVector& LaunchVelocity)
+{
+	bLaunched = true;
+	SetActorLocation(Location, false, nullptr, ETeleportType::TeleportPhysics);
+	StartLocation = Location;
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// the movement component lets go of the root when it stops on a hit
+	ProjectileMovement->SetUpdatedComponent(RootComponent);
+	ProjectileMovement->Activate(true);
+	SetVelocity(LaunchVelocity);
+	ScheduleExpiry(MaxDistance, LaunchVelocity);
+}
+
+void AGrapple::Release()
+{
+	if (!bLaunched)
+		return;
+
+	bLaunched = false;
+	CancelExpiry();
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	OnReleased.Broadcast(this);
+}
+
+void AGrapple::SaveSnapshot(FGrappleSnapshot& Snapshot) const
+{
+	Snapshot.bHookLaunched = bLaunched;
+	Snapshot.bHookMoving = bLaunched && ProjectileMovement->IsActive() && ProjectileMovement->UpdatedComponent != nullptr;
+	Snapshot.HookLocation = GetActorLocation();
+	Snapshot.HookVelocity = ProjectileMovement->Velocity;
+	Snapshot.HookStartLocation = StartLocation;
+}
+
+void AGrapple::RestoreSnapshot(const FGrappleSnapshot& Snapshot)
+{
+	bLaunched = Snapshot.bHookLaunched;
+	StartLocation = Snapshot.HookStartLocation;
+	SetActorLocation(Snapshot.HookLocation, false, nullptr, ETeleportType::TeleportPhysics);
+	SetActorHiddenInGame(!bLaunched);
+	SetActorEnableCollision(bLaunched);
+
+	CancelExpiry();
+	if (Snapshot.bHookMoving)
+	{
+		ProjectileMovement->SetUpdatedComponent(RootComponent);
+		ProjectileMovement->Activate(true);
+		SetVelocity(Snapshot.HookVelocity);
+		// whatever is left of the flight
+		ScheduleExpiry(MaxDistance - FVector::Distance(StartLocation, Snapshot.HookLocation), Snapshot.HookVelocity);
+	}
+	else
 	{
-		Destroy();
+		ProjectileMovement->StopMovementImmediately();
+		ProjectileMovement->Deactivate();
 	}
 }
 
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GrappleRewindComponent.h"
+#include "MovementMechanicsStats.h"
+#include "GrappleRewindSubsystem.h"
+
+UGrappleRewindComponent::UGrappleRewindComponent()
+{
+	// the subsystem records the transform, this component doesn't need to tick
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UGrappleRewindComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// clients don't record
+	UGrappleRewindSubsystem* rewind = GetWorld()->GetSubsystem<UGrappleRewindSubsystem>();
+	if (rewind && rewind->IsRecording())
+	{
+		if (!rewind->RegisterActor(GetOwner()))
+			UE_LOG(LogMovementMechanics, Warning, TEXT("Grapple rewind is full, %s won't be rewound"), *GetOwner()->GetName());
+	}
+}
+
+void UGrappleRewindComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UGrappleRewindSubsystem* rewind = GetWorld()->GetSubsystem<UGrappleRewindSubsystem>())
+		rewind->UnregisterActor(GetOwner());
+
+	Super::EndPlay(EndPlayReason);
+}
@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GrappleRewindSubsystem.h"
+#include "MovementMechanicsStats.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+void UGrappleRewindSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// only the server validates
+	bRecording = InWorld.GetNetMode() != NM_Client;
+	if (!bRecording)
+		return;
+
+	LLM_SCOPE_BYTAG(MovementSubsystems);
+
+	FrameTimes.SetNumZeroed(NumFrames);
+	Locations.SetNumZeroed(NumFrames * MaxActors);
+	Rotations.Init(FQuat::Identity, NumFrames * MaxActors);
+	Actors.SetNum(MaxActors);
+	LocalBounds.SetNumZeroed(MaxActors);
+	Scales.Init(FVector::OneVector, MaxActors);
+	IgnoredActors.Reserve(MaxActors);
+
+	SET_MEMORY_STAT(STAT_GrappleRewindMemory, GetAllocatedSize());
+}
+
+bool UGrappleRewindSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* world = Cast<UWorld>(Outer);
+	return world && world->IsGameWorld() && Super::ShouldCreateSubsystem(Outer);
+}
+
+SIZE_T UGrappleRewindSubsystem::GetAllocatedSize() const
+{
+	return FrameTimes.GetAllocatedSize() + Locations.GetAllocatedSize() + Rotations.GetAllocatedSize()
+		+ Actors.GetAllocatedSize() + LocalBounds.GetAllocatedSize() + Scales.GetAllocatedSize() + IgnoredActors.GetAllocatedSize();
+}
+
+void UGrappleRewindSubsystem::Tick(float DeltaTime)
+{
+	if (!bRecording)
+		return;
+
+	LLM_SCOPE_BYTAG(MovementSubsystems);
+	HeadFrame = (HeadFrame + 1) % NumFrames;
+	RecordedFrames = FMath::Min(RecordedFrames + 1, NumFrames);
+	FrameTimes[HeadFrame] = GetWorld()->GetTimeSeconds();
+
+	const int32 frameStart = HeadFrame * MaxActors;
+	for (int32 slot = 0; slot < MaxActors; slot++)
+	{
+		if (AActor* actor = Actors[slot].Get())
+		{
+			Locations[frameStart + slot] = actor->GetActorLocation();
+			Rotations[frameStart + slot] = actor->GetActorQuat();
+		}
+	}
+}
+
+TStatId UGrappleRewindSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGrappleRewindSubsystem, STATGROUP_Tickables);
+}
+
+bool UGrappleRewindSubsystem::RegisterActor(AActor* Actor)
+{
+	if (!bRecording)
+		return false;
+
+	int32 freeSlot = INDEX_NONE;
+	for (int32 slot = 0; slot < MaxActors; slot++)
+	{
+		AActor* current = Actors[slot].Get();
+		if (current == Actor)
+			return true;
+		if (!current && freeSlot == INDEX_NONE)
+			freeSlot = slot;
+	}
+	if (freeSlot == INDEX_NONE)
+		return false;
+
+	Actors[freeSlot] = Actor;
+	LocalBounds[freeSlot] = Actor->CalculateComponentsBoundingBoxInLocalSpace();
+	Scales[freeSlot] = Actor->GetActorScale3D();
+
+	// fill the history so a rewind before the actor was registered uses its current transform
+	for (int32 frame = 0; frame < NumFrames; frame++)
+	{
+		Locations[frame * MaxActors + freeSlot] = Actor->GetActorLocation();
+		Rotations[frame * MaxActors + freeSlot] = Actor->GetActorQuat();
+	}
+	return true;
+}
+
+void UGrappleRewindSubsystem::UnregisterActor(AActor* Actor)
+{
+	for (int32 slot = 0; slot < MaxActors; slot++)
+	{
+		if (Actors[slot].Get() == Actor)
+		{
+			Actors[slot] = nullptr;
+			return;
+		}
+	}
+}
+
+bool UGrappleRewindSubsystem::FindFrames(float Timestamp, int32& OutOlder, int32& OutNewer, float& OutAlpha) const
+{
+	if (RecordedFrames == 0)
+		return false;
+
+	// walk back from the newest frame until the timestamp is between two frames
+	OutNewer = HeadFrame;
+	OutOlder = HeadFrame;
+	OutAlpha = 0.0f;
+	if (Timestamp >= FrameTimes[HeadFrame])
+		return true;
+
+	for (int32 i = 1; i < RecordedFrames; i++)
+	{
+		const int32 frame = (HeadFrame - i + NumFrames) % NumFrames;
+		if (FrameTimes[frame] <= Timestamp)
+		{
+			OutOlder = frame;
+			const float span = FrameTimes[OutNewer] - FrameTimes[OutOlder];
+			OutAlpha = span > 0.0f ? (Timestamp - FrameTimes[OutOlder]) / span : 0.0f;
+			return true;
+		}
+		OutNewer = frame;
+	}
+
+	// older than the history, use the oldest frame
+	OutOlder = OutNewer;
+	return true;
+}
+
+bool UGrappleRewindSubsystem::RewindTrace(const FVector& Start, const FVector& End, float Timestamp, const AActor* IgnoreActor, ECollisionChannel Channel, FHitResult& OutHit)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GrappleRewindTrace);
+
+	// the tracked actors are tested at their old transform, so leave them out of the world trace
+	IgnoredActors.Reset();
+	for (const TWeakObjectPtr<AActor>& actor : Actors)
+	{
+		if (actor.IsValid())
+			IgnoredActors.Add(actor.Get());
+	}
+
+	FCollisionQueryParams traceParams(SCENE_QUERY_STAT(GrappleRewind), false, IgnoreActor);
+	traceParams.AddIgnoredActors(IgnoredActors);
+	bool hit = GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, Channel, traceParams);
+	float closestTime = hit ? OutHit.Time : 1.0f;
+
+	int32 older;
+	int32 newer;
+	float alpha;
+	if (!FindFrames(Timestamp, older, newer, alpha))
+		return hit;
+
+	for (int32 slot = 0; slot < MaxActors; slot++)
+	{
+		AActor* actor = Actors[slot].Get();
+		if (!actor || actor == IgnoreActor)
+			continue;
+
+		// transform of the actor at the timestamp
+		const FVector location = FMath::Lerp(Locations[older * MaxActors + slot], Locations[newer * MaxActors + slot], alpha);
+		const FQuat rotation = FQuat::Slerp(Rotations[older * MaxActors + slot], Rotations[newer * MaxActors + slot], alpha);
+		const FTransform transform(rotation, location, Scales[slot]);
+
+		const FVector localStart = transform.InverseTransformPosition(Start);
+		const FVector localEnd = transform.InverseTransformPosition(End);
+		FVector localHit;
+		FVector localNormal;
+		float time;
+		if (FMath::LineExtentBoxIntersection(LocalBounds[slot], localStart, localEnd, FVector::ZeroVector, localHit, localNormal, time) && time < closestTime)
+		{
+			closestTime = time;
+			hit = true;
+			OutHit = FHitResult(actor, nullptr, transform.TransformPosition(localHit), transform.TransformVectorNoScale(localNormal));
+			OutHit.bBlockingHit = true;
+			OutHit.Time = time;
+			OutHit.TraceStart = Start;
+			OutHit.TraceEnd = End;
+			OutHit.Location = OutHit.ImpactPoint;
+			OutHit.Distance = (End - Start).Size() * time;
+		}
+	}
+	return hit;
+}
+
+void UGrappleRewindSubsystem::RecordValidation(bool bConfirmed, double ValidationSeconds, float RewindSeconds)
+{
+	if (bConfirmed)
+		ValidationStats.Confirmed++;
+	else
+		ValidationStats.Rejected++;
+	ValidationStats.ValidationTime += ValidationSeconds;
+	ValidationStats.MaxValidationTime = FMath::Max(ValidationStats.MaxValidationTime, ValidationSeconds);
+	ValidationStats.RewindTime += RewindSeconds;
+}
+
+FGrappleValidationStats UGrappleRewindSubsystem::ConsumeValidationStats()
+{
+	FGrappleValidationStats stats = ValidationStats;
+	ValidationStats = FGrappleValidationStats();
+	return stats;
+}
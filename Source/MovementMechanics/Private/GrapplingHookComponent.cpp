@@ -1,9 +1,11 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 #include "GrapplingHookComponent.h"
+#include "MovementMechanicsStats.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "CableComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Character.h"
+#include "MovementMechanicsCollision.h"
 
 // Sets default values for this component's properties
 UGrapplingHookComponent::UGrapplingHookComponent()
@@ -11,7 +13,10 @@ UGrapplingHookComponent::UGrapplingHookComponent()
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
-	// ...
+	// only ticks while the grapple is attached
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	// the pull force is added before the owner's movement component integrates it, see the character BeginPlay
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
 }
 
 
@@ -20,16 +25,17 @@ void UGrapplingHookComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ...
-	
+	// the curve is only read here, the tick samples the table
+	PullForceTable.Bake(PullForceCurve);
 }
 
 
 // Called every frame
 void UGrapplingHookComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
+	LLM_SCOPE_BYTAG(MovementGrapple);
+	MOVEMENT_SCOPE_TIMER(STAT_MovementGrappleTick, EMovementTimer::GrappleTick);
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	TimeSinceLastGrappleDetach += DeltaTime;
 
 	// if grapple is attached then apply force to the player
 	if (GrappleState == ATTACHED)
@@ -37,11 +43,14 @@ void UGrapplingHookComponent::TickComponent(float DeltaTime, ELevelTick TickType
 		ACharacter* playerCharacter = Cast<ACharacter>(GetOwner());
 		UCharacterMovementComponent* playerMovement = playerCharacter->GetCharacterMovement();
 
-		FVector grapplePull = ToGrappleHook() * PerTickPulForce;
+		UpdateWrapPoints();
+
+		// pull towards the last point the cable wraps around, or the hook
+		FVector grapplePull = ToGrappleHook() * GetPullForce();
 		playerMovement->AddForce(grapplePull);
 
 		// test if player is close enought to grapple then detach
-		if (UKismetMathLibrary::Vector_Distance(GrappleHook->GetActorLocation(), GetOwner()->GetActorLocation()) < DisconnectDistance)
+		if (WrapPoints.Num() == 0 && UKismetMathLibrary::Vector_Distance(GrappleHook->GetActorLocation(), GetOwner()->GetActorLocation()) < DisconnectDistance)
 			DetachGrapple();
 		else
 		{
@@ -94,73 +103,162 @@ void UGrapplingHookComponent::FireGrapple(FVector targetLocation, FVector localO
 	if (IsInUse())
 		return;
 
-	GrappleState = FIRING;
+	LLM_SCOPE_BYTAG(MovementGrapple);
+	MOVEMENT_SCOPE_TIMER(STAT_MovementGrappleSpawn, EMovementTimer::GrappleSpawn);
+	SetGrappleState(FIRING);
 
 	FVector fireDirection = targetLocation - CableStartLocation(localOffset);
 	fireDirection.Normalize();
 	FVector grappleVelocity = fireDirection * GrappleSpeed;
-	FTransform SpawnTransform = GetOwner()->GetActorTransform();
+	FVector startLocation = CableStartLocation(localOffset);
+
+	// the hook and cable are spawned on the first shot and reused afterwards
+	if (!GrappleHook || !GrappleCable)
+		SpawnGrappleActors(startLocation);
+
+	if (!GrappleHook)
+	{
+		UE_VLOG_UELOG(GetOwner(), LogMovementMechanics, Error, TEXT("%s could not spawn the grapple hook"), *GetNameSafe(GetOwner()));
+		SetGrappleState(READY);
+		return;
+	}
+
+	GrappleHook->Launch(startLocation, grappleVelocity);
+
+	if (GrappleCable)
+	{
+		GrappleCable->SetActorLocation(startLocation);
+		GrappleCable->SetActorHiddenInGame(false);
+		GrappleCable->CableComponent->SetComponentTickEnabled(true);
+	}
+}
 
+void UGrapplingHookComponent::SpawnGrappleActors(const FVector& Location)
+{
 	UWorld* MyLevel = GetWorld();
-	if (MyLevel)
+	if (!MyLevel)
+		return;
+
+	FTransform SpawnTransform = FTransform::Identity;
+	SpawnTransform.SetLocation(Location);
+
+	if (!GrappleHook)
 	{
 		FActorSpawnParameters SpawnParams;
 		SpawnParams.Owner = GetOwner();
-		SpawnTransform.SetRotation(FQuat4d(0, 0, 0, 1.0f));
-		SpawnTransform.SetScale3D(FVector(1.0f, 1.0f, 1.0f));
-		SpawnTransform.SetLocation(CableStartLocation(localOffset));
 		// spawn grappple hook
 		GrappleHook = MyLevel->SpawnActor<AGrapple>(HookClass, SpawnTransform, SpawnParams);
 
-		if (!GrappleHook)
-			GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Red, TEXT("Error Spawning Grapple Hook"));
-		else
+		if (GrappleHook)
 		{
-			// set initial velocity 
-			GrappleHook->SetVelocity(grappleVelocity);
 			// bind hit event
 			GrappleHook->GetCollisionComponent()->OnComponentHit.AddDynamic(this, &UGrapplingHookComponent::OnGrappleHit);
+			// bind release event, called when the hook is detached or goes past its max distance
+			GrappleHook->OnReleased.AddUObject(this, &UGrapplingHookComponent::OnGrappleReleased);
 			// bind destroy event
 			GrappleHook->OnDestroyed.AddDynamic(this, &UGrapplingHookComponent::OnGrappleDestroyed);
 		}
-			
-		if (CableClass)
-		{
-			SpawnTransform.SetScale3D(FVector(1.0f, 1.0f, 1.0f));
-			SpawnTransform.Rotator() = UKismetMathLibrary::MakeRotFromX(fireDirection);
-			SpawnTransform.SetLocation(CableStartLocation(localOffset));
-			GrappleCable = MyLevel->SpawnActor<AGrappleCable>(CableClass, SpawnTransform);
-		}
+	}
 
+	if (!GrappleCable && CableClass)
+	{
+		GrappleCable = MyLevel->SpawnActor<AGrappleCable>(CableClass, SpawnTransform);
+
+		// attach cable to the player
+		if (GrappleCable)
+			GrappleCable->AttachToActor(GetOwner(), FAttachmentTransformRules::KeepWorldTransform);
+		else
+			UE_VLOG_UELOG(GetOwner(), LogMovementMechanics, Error, TEXT("%s could not spawn the grapple cable"), *GetNameSafe(GetOwner()));
 	}
 
-	if(!GrappleHook)
-		GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Red, TEXT("Error Spawning Grapple Hook"));
-	
-	// attach cable to the player
-	if (GrappleCable)
-		GrappleCable->AttachToActor(GetOwner(), FAttachmentTransformRules::KeepWorldTransform);
-	else
-		GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Red, TEXT("Error attaching cable to player"));
 	// attach cable to hook
 	if (GrappleHook && GrappleCable)
+	{
 		GrappleCable->CableComponent->SetAttachEndTo(GrappleHook, FName());
-	else
-		GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Red, TEXT("Error attaching cable to hook"));
-
-	// by default end location of cable component is (100, 0, 0), set it to 0
-	if (GrappleHook && GrappleCable)
+		// by default end location of cable component is (100, 0, 0), set it to 0
 		GrappleCable->CableComponent->EndLocation = FVector(0, 0, 0);
+	}
+	else
+		UE_VLOG_UELOG(GetOwner(), LogMovementMechanics, Error, TEXT("%s could not attach the grapple cable to the hook"), *GetNameSafe(GetOwner()));
 }
 
 void UGrapplingHookComponent::DetachGrapple()
 {
+	if (GrappleHook && GrappleHook->IsLaunched())
+	{
+		GrappleHook->Release();
+	}
+
+	LastGrappleDetachTime = GetWorld()->GetTimeSeconds();
+	OnGrappleDetached.Broadcast();
+}
+
+float UGrapplingHookComponent::GetTimeSinceLastGrappleDetach()
+{
+	return GetWorld()->GetTimeSeconds() - LastGrappleDetachTime;
+}
+
+void UGrapplingHookComponent::SetGrappleState(UGrappleState NewState)
+{
+	if (GrappleState == NewState)
+		return;
+
+	GrappleState = NewState;
+	SetComponentTickEnabled(GrappleState == ATTACHED);
+	OnGrappleStateChanged.Broadcast(GrappleState);
+}
+
+void UGrapplingHookComponent::SaveSnapshot(FGrappleSnapshot& Snapshot) const
+{
+	Snapshot.State = (uint8)GrappleState;
+	Snapshot.InitialHookDirection2D = InitialHookDirection2D;
+	Snapshot.DetachTimeOffset = LastGrappleDetachTime - GetWorld()->GetTimeSeconds();
+	Snapshot.AttachTimeOffset = AttachTime - GetWorld()->GetTimeSeconds();
+	Snapshot.LastOwnerLocation = LastOwnerLocation;
+	Snapshot.NumWrapPoints = FMath::Min(WrapPoints.Num(), FGrappleSnapshot::MaxWrapPoints);
+	for (int32 i = 0; i < Snapshot.NumWrapPoints; i++)
+	{
+		Snapshot.WrapPoints[i] = WrapPoints[i];
+		Snapshot.WrapPlaneNormals[i] = WrapPlaneNormals[i];
+	}
+
 	if (GrappleHook)
 	{
-		GrappleHook->Destroy();
+		GrappleHook->SaveSnapshot(Snapshot);
+	}
+	else
+	{
+		Snapshot.bHookLaunched = false;
+		Snapshot.bHookMoving = false;
+	}
+}
+
+void UGrapplingHookComponent::RestoreSnapshot(const FGrappleSnapshot& Snapshot)
+{
+	GrappleState = (UGrappleState)Snapshot.State;
+	SetComponentTickEnabled(GrappleState == ATTACHED);
+	InitialHookDirection2D = Snapshot.InitialHookDirection2D;
+	LastGrappleDetachTime = GetWorld()->GetTimeSeconds() + Snapshot.DetachTimeOffset;
+	AttachTime = GetWorld()->GetTimeSeconds() + Snapshot.AttachTimeOffset;
+	LastOwnerLocation = Snapshot.LastOwnerLocation;
+	WrapPoints.Reset();
+	WrapPlaneNormals.Reset();
+	for (int32 i = 0; i < Snapshot.NumWrapPoints; i++)
+	{
+		WrapPoints.Add(Snapshot.WrapPoints[i]);
+		WrapPlaneNormals.Add(Snapshot.WrapPlaneNormals[i]);
 	}
 
-	TimeSinceLastGrappleDetach = 0.0f;
+	// the hook may have been destroyed since the snapshot was taken
+	if (Snapshot.bHookLaunched && (!GrappleHook || !GrappleCable))
+		SpawnGrappleActors(Snapshot.HookLocation);
+	if (GrappleHook)
+		GrappleHook->RestoreSnapshot(Snapshot);
+	if (GrappleCable)
+	{
+		GrappleCable->SetActorHiddenInGame(GrappleState == READY);
+		GrappleCable->CableComponent->SetComponentTickEnabled(GrappleState != READY);
+	}
 }
 
 FVector UGrapplingHookComponent::CableStartLocation(FVector localOffSet)
@@ -172,17 +270,22 @@ FVector UGrapplingHookComponent::CableStartLocation(FVector localOffSet)
 	return playerLocation + offsetInLocalSpace;
 }
 
+float UGrapplingHookComponent::GetPullForce() const
+{
+	return PerTickPulForce * PullForceTable.Evaluate(GetWorld()->GetTimeSeconds() - AttachTime);
+}
+
 FVector UGrapplingHookComponent::ToGrappleHook()
 {
 	FVector direction = FVector(0, 0, 0);
 	if (GrappleHook)
 	{
 		//UE_LOG(LogTemp, Warning, TEXT("Hook Location %f"), direction.X);
-		direction = GrappleHook->GetActorLocation() - GetOwner()->GetActorLocation();
+		direction = GetCableAnchor() - GetOwner()->GetActorLocation();
 	}
 	else
 	{
-		GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Red, TEXT("Error Grapple hook actor not created"));
+		UE_VLOG_UELOG(GetOwner(), LogMovementMechanics, Error, TEXT("%s has no grapple hook actor"), *GetNameSafe(GetOwner()));
 	}
 	direction.Normalize();
 	return direction;
@@ -198,7 +301,9 @@ FVector UGrapplingHookComponent::ToGrappleHook2D()
 
 void UGrapplingHookComponent::OnGrappleHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
-	GrappleState = ATTACHED;
+	UE_VLOG_LOCATION(GetOwner(), LogMovementMechanics, Log, Hit.ImpactPoint, 15.0f, FColor::Cyan, TEXT("Hook hit %s"), *GetNameSafe(OtherActor));
+	AttachTime = GetWorld()->GetTimeSeconds();
+	SetGrappleState(ATTACHED);
 	ACharacter* playerCharacter = Cast<ACharacter>(GetOwner());
 
 	// set grappling movement characteristics
@@ -215,15 +320,96 @@ void UGrapplingHookComponent::OnGrappleHit(UPrimitiveComponent* HitComp, AActor*
 
 	playerMovement->Velocity = initialPlayerVelocity;
 	InitialHookDirection2D = ToGrappleHook2D();
+
+	WrapPoints.Reset();
+	WrapPlaneNormals.Reset();
+	LastOwnerLocation = GetOwner()->GetActorLocation();
+}
+
+FVector UGrapplingHookComponent::GetCableAnchor()
+{
+	if (WrapPoints.Num() > 0)
+		return WrapPoints.Last();
+	return GrappleHook ? GrappleHook->GetActorLocation() : GetOwner()->GetActorLocation();
+}
+
+void UGrapplingHookComponent::UpdateWrapPoints()
+{
+	const FVector current = GetOwner()->GetActorLocation();
+	const FVector anchor = GetCableAnchor();
+
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(GrappleWrap), false, GetOwner());
+	TraceParams.AddIgnoredActor(GrappleHook);
+
+	// one trace along the current cable segment, if it is blocked the cable swept into something since last frame
+	FHitResult hit;
+	if (WrapPoints.Num() < MaxWrapPoints && GetWorld()->LineTraceSingleByChannel(hit, anchor, current, ECC_Grapple, TraceParams))
+	{
+		// search the triangle between the last and current segment for where the cable first touched,
+		// a fixed number of traces however many wraps there are
+		float clear = 0.0f;
+		float blocked = 1.0f;
+		for (int32 i = 0; i < WrapSearchIterations; i++)
+		{
+			float middle = (clear + blocked) * 0.5f;
+			FHitResult middleHit;
+			if (GetWorld()->LineTraceSingleByChannel(middleHit, anchor, FMath::Lerp(LastOwnerLocation, current, middle), ECC_Grapple, TraceParams))
+			{
+				blocked = middle;
+				hit = middleHit;
+			}
+			else
+				clear = middle;
+		}
+
+		// keep the wrap point off the surface so the next segment doesn't start inside it
+		FVector wrapPoint = hit.ImpactPoint + hit.ImpactNormal * WrapSurfaceOffset;
+		WrapPoints.Add(wrapPoint);
+		// side the cable bent to, used to know when it unwinds
+		WrapPlaneNormals.Add(FVector::CrossProduct(wrapPoint - anchor, current - wrapPoint).GetSafeNormal());
+		InitialHookDirection2D = ToGrappleHook2D();
+	}
+	else if (WrapPoints.Num() > 0)
+	{
+		// unwind when the player swings back past the line from the previous anchor through the last wrap point
+		const FVector wrapPoint = WrapPoints.Last();
+		const FVector previous = WrapPoints.Num() > 1 ? WrapPoints[WrapPoints.Num() - 2] : GrappleHook->GetActorLocation();
+		const FVector bend = FVector::CrossProduct(wrapPoint - previous, current - wrapPoint);
+		if (FVector::DotProduct(bend, WrapPlaneNormals.Last()) < 0.0f)
+		{
+			WrapPoints.Pop(false);
+			WrapPlaneNormals.Pop(false);
+			InitialHookDirection2D = ToGrappleHook2D();
+		}
+	}
+
+	LastOwnerLocation = current;
 }
 
 void UGrapplingHookComponent::OnGrappleDestroyed(AActor* Act)
 {
-	GrappleState = READY;
+	if (IsInUse())
+		OnGrappleReleased(GrappleHook);
+	GrappleHook = nullptr;
 
-	// add destroy the cable
+	// the cable can't be reused without its hook
 	if (GrappleCable)
 		GrappleCable->Destroy();
+	GrappleCable = nullptr;
+}
+
+void UGrapplingHookComponent::OnGrappleReleased(AGrapple* Hook)
+{
+	SetGrappleState(READY);
+	WrapPoints.Reset();
+	WrapPlaneNormals.Reset();
+
+	// hide the cable until the next shot
+	if (GrappleCable)
+	{
+		GrappleCable->SetActorHiddenInGame(true);
+		GrappleCable->CableComponent->SetComponentTickEnabled(false);
+	}
 
 	ACharacter* playerCharacter = Cast<ACharacter>(GetOwner());
 
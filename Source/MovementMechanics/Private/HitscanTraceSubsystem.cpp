@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitscanTraceSubsystem.h"
+#include "MovementMechanicsStats.h"
+#include "Engine/World.h"
+#include "Components/PrimitiveComponent.h"
+
+void UHitscanTraceSubsystem::QueueShot(const FVector& Start, const FVector& End, float Impulse, AActor* Instigator)
+{
+	QueuedShots.Add({ Start, End, Impulse, Instigator });
+}
+
+void UHitscanTraceSubsystem::Tick(float DeltaTime)
+{
+	LLM_SCOPE_BYTAG(MovementSubsystems);
+	SCOPE_CYCLE_COUNTER(STAT_HitscanResolve);
+	ResolvePendingTraces();
+	SubmitQueuedShots();
+}
+
+TStatId UHitscanTraceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHitscanTraceSubsystem, STATGROUP_Tickables);
+}
+
+void UHitscanTraceSubsystem::ResolvePendingTraces()
+{
+	UWorld* world = GetWorld();
+	FTraceDatum traceData;
+	LastResolvedCount = 0;
+	for (int32 i = 0; i < PendingHandles.Num(); i++)
+	{
+		if (!world->QueryTraceData(PendingHandles[i], traceData))
+			continue;
+		LastResolvedCount++;
+		if (traceData.OutHits.Num() == 0)
+			continue;
+
+		const FHitResult& hit = traceData.OutHits[0];
+		const FHitscanShot& shot = PendingShots[i];
+		UPrimitiveComponent* otherComp = hit.GetComponent();
+		AActor* otherActor = hit.GetActor();
+
+		// same rule as the projectile, only push physics objects
+		if ((otherActor != nullptr) && (otherActor != shot.Instigator.Get()) && (otherComp != nullptr) && otherComp->IsSimulatingPhysics())
+		{
+			FVector direction = (shot.End - shot.Start).GetSafeNormal();
+			otherComp->AddImpulseAtLocation(direction * shot.Impulse, hit.ImpactPoint);
+		}
+	}
+	PendingHandles.Reset();
+	PendingShots.Reset();
+}
+
+void UHitscanTraceSubsystem::SubmitQueuedShots()
+{
+	if (QueuedShots.Num() == 0)
+		return;
+
+	SET_DWORD_STAT(STAT_HitscanTracesPerFrame, QueuedShots.Num());
+
+	UWorld* world = GetWorld();
+	FCollisionQueryParams traceParams(SCENE_QUERY_STAT(HitscanShot), false);
+	for (const FHitscanShot& shot : QueuedShots)
+	{
+		traceParams.ClearIgnoredActors();
+		traceParams.AddIgnoredActor(shot.Instigator.Get());
+		PendingHandles.Add(world->AsyncLineTraceByChannel(EAsyncTraceType::Single, shot.Start, shot.End, TraceChannel, traceParams));
+	}
+
+	// the queue keeps its allocation, the pending list takes the shots
+	Swap(PendingShots, QueuedShots);
+	QueuedShots.Reset();
+}
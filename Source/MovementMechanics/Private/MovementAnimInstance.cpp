@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementAnimInstance.h"
+#include "MovementMechanicsStats.h"
+
+void UMovementAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeUpdateAnimation(DeltaSeconds);
+
+	// game thread
+	if (const AMovementMechanicsCharacter* character = Cast<AMovementMechanicsCharacter>(GetOwningActor()))
+		character->GetAnimSnapshot(PendingSnapshot);
+}
+
+void UMovementAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
+
+	Movement = PendingSnapshot;
+	GroundSpeed = Movement.Velocity.Size2D();
+	bGrappleAttached = Movement.GrappleState == ATTACHED;
+
+	float targetLean = 0.0f;
+	if (Movement.bWallRunning)
+		targetLean = Movement.WallSide == LEFT ? -WallRunLeanAngle : WallRunLeanAngle;
+	WallRunLean = FMath::FInterpTo(WallRunLean, targetLean, DeltaSeconds, WallRunLeanSpeed);
+}
+
+UMovementSkeletalMeshComponent::UMovementSkeletalMeshComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	SetAutoRegisterWithBudgetAllocator(false);
+	SetAutoCalculateSignificance(true);
+}
+
+void UMovementSkeletalMeshComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	MOVEMENT_SCOPE_TIMER(STAT_MovementAnimTick, EMovementTimer::AnimTick);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
@@ -0,0 +1,512 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementBenchmarkCommandlet.h"
+#include "MovementMechanicsStats.h"
+#include "MovementSimulation.h"
+#include "MovementStressCourse.h"
+#include "MovementMechanicsCharacter.h"
+#include "PickUpProximitySubsystem.h"
+#include "TP_PickUpComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+#include "Dom/JsonObject.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+UMovementBenchmarkCommandlet::UMovementBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UMovementBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString outputPath;
+	if (!FParse::Value(*Params, TEXT("Output="), outputPath))
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("MovementBenchmark needs -Output="));
+		return 1;
+	}
+
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Pawn="), PawnClassName);
+	FParse::Value(*Params, TEXT("Timestep="), Timestep);
+	FParse::Value(*Params, TEXT("Warmup="), WarmupTime);
+	FParse::Value(*Params, TEXT("Duration="), Duration);
+	FParse::Value(*Params, TEXT("Threshold="), Threshold);
+	bUseCourse = FParse::Value(*Params, TEXT("CourseSeed="), CourseSeed);
+	FParse::Value(*Params, TEXT("PickUps="), PickUps);
+	bCompareWallTraces = FParse::Param(*Params, TEXT("CompareWallTraces"));
+	FString policyString;
+	if (FParse::Value(*Params, TEXT("Policy="), policyString))
+	{
+		if (policyString == TEXT("Server"))
+			Policy = EMovementPolicy::Server;
+		else if (policyString != TEXT("Bot"))
+			UE_LOG(LogMovementMechanics, Warning, TEXT("Unknown policy %s, the characters have no player input so only Bot and Server can be used"), *policyString);
+	}
+#if !UE_BUILD_SHIPPING
+	bCheckAllocations = FParse::Param(*Params, TEXT("CheckAllocations"));
+	if (bCheckAllocations)
+		FMovementAllocationTracker::Install();
+#endif
+	FString countsString;
+	if (FParse::Value(*Params, TEXT("Counts="), countsString, false))
+	{
+		TArray<FString> counts;
+		countsString.ParseIntoArray(counts, TEXT(","));
+		CharacterCounts.Reset();
+		for (const FString& count : counts)
+			CharacterCounts.Add(FCString::Atoi(*count));
+	}
+
+	UWorld* templateWorld = MovementSimulation::LoadTemplateWorld(MapName);
+	if (!templateWorld)
+		return 1;
+
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(Timestep);
+
+	TSharedPtr<FJsonObject> results = MakeShared<FJsonObject>();
+	results->SetStringField(TEXT("Map"), MapName);
+	results->SetNumberField(TEXT("Timestep"), Timestep);
+	results->SetNumberField(TEXT("Duration"), Duration);
+	if (bUseCourse)
+		results->SetNumberField(TEXT("CourseSeed"), CourseSeed);
+	results->SetStringField(TEXT("Policy"), Policy == EMovementPolicy::Server ? TEXT("Server") : TEXT("Bot"));
+	TSharedPtr<FJsonObject> cases = MakeShared<FJsonObject>();
+	for (int32 i = 0; i < CharacterCounts.Num(); i++)
+		cases->SetObjectField(FString::FromInt(CharacterCounts[i]), RunCase(templateWorld, CharacterCounts[i]));
+	results->SetObjectField(TEXT("Cases"), cases);
+
+	// kept out of Cases so the baseline comparison only sees the movement timers
+	if (PickUps > 0)
+	{
+		results->SetNumberField(TEXT("PickUps"), PickUps);
+		TSharedPtr<FJsonObject> pickUpCases = MakeShared<FJsonObject>();
+		for (int32 i = 0; i < CharacterCounts.Num(); i++)
+		{
+			TSharedPtr<FJsonObject> pickUpCase = MakeShared<FJsonObject>();
+			pickUpCase->SetObjectField(TEXT("Hash"), RunPickUpCase(templateWorld, CharacterCounts[i], true));
+			pickUpCase->SetObjectField(TEXT("Overlap"), RunPickUpCase(templateWorld, CharacterCounts[i], false));
+			pickUpCases->SetObjectField(FString::FromInt(CharacterCounts[i]), pickUpCase);
+		}
+		results->SetObjectField(TEXT("PickUpCases"), pickUpCases);
+	}
+
+	if (bCompareWallTraces)
+	{
+		TSharedPtr<FJsonObject> wallRunCases = MakeShared<FJsonObject>();
+		for (int32 i = 0; i < CharacterCounts.Num(); i++)
+		{
+			TSharedPtr<FJsonObject> wallRunCase = MakeShared<FJsonObject>();
+			wallRunCase->SetObjectField(TEXT("Cached"), RunWallRunCase(templateWorld, CharacterCounts[i], true));
+			wallRunCase->SetObjectField(TEXT("Traced"), RunWallRunCase(templateWorld, CharacterCounts[i], false));
+			wallRunCases->SetObjectField(FString::FromInt(CharacterCounts[i]), wallRunCase);
+		}
+		results->SetObjectField(TEXT("WallRunCases"), wallRunCases);
+	}
+
+	FString json;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+	FJsonSerializer::Serialize(results.ToSharedRef(), writer);
+	if (!FFileHelper::SaveStringToFile(json, *outputPath))
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Could not write %s"), *outputPath);
+		return 1;
+	}
+
+	if (AllocationFailures > 0)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("MovementBenchmark found %d allocations in the movement loop"), AllocationFailures);
+		return 1;
+	}
+
+	FString baselinePath;
+	if (FParse::Value(*Params, TEXT("Baseline="), baselinePath))
+	{
+		int32 regressions = CompareWithBaseline(results, baselinePath);
+		if (regressions > 0)
+		{
+			UE_LOG(LogMovementMechanics, Error, TEXT("MovementBenchmark found %d regressions above %.0f%%"), regressions, Threshold * 100.0f);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+TSharedPtr<FJsonObject> UMovementBenchmarkCommandlet::RunCase(UWorld* TemplateWorld, int32 CharacterCount)
+{
+	UWorld* world = MovementSimulation::CreateWorld(TemplateWorld, CharacterCount);
+	FTransform spawnTransform = MovementSimulation::FindSpawnTransform(world);
+
+	const uint32 courseHash = SpawnCourse(world, spawnTransform);
+
+	FMovementTimings::Reset();
+	// sampling the timers allocates, so it is off while allocations are checked
+	FMovementTimings::bRecording = !bCheckAllocations;
+
+	TArray<AMovementMechanicsCharacter*> characters;
+	SpawnCharacters(world, CharacterCount, spawnTransform, characters);
+	TArray<double> characterSpawnSamples = MoveTemp(FMovementTimings::Samples[(int32)EMovementTimer::CharacterSpawn]);
+
+	TArray<double> frameSamples;
+	for (float time = 0.0f; time < WarmupTime + Duration; time += Timestep)
+	{
+		// drop everything recorded during the warm up
+		if (time < WarmupTime && time + Timestep >= WarmupTime)
+		{
+			FMovementTimings::Reset();
+#if !UE_BUILD_SHIPPING
+			FMovementAllocationTracker::Reset();
+			FMovementAllocationTracker::bEnabled = bCheckAllocations;
+#endif
+		}
+
+		for (int32 i = 0; i < characters.Num(); i++)
+			DriveCharacter(characters[i], i, time);
+
+		FApp::SetDeltaTime(Timestep);
+		const double frameStart = FPlatformTime::Seconds();
+		world->Tick(LEVELTICK_All, Timestep);
+		if (time >= WarmupTime)
+			frameSamples.Add((FPlatformTime::Seconds() - frameStart) * 1000000.0);
+		GFrameCounter++;
+	}
+	FMovementTimings::bRecording = false;
+#if !UE_BUILD_SHIPPING
+	FMovementAllocationTracker::bEnabled = false;
+#endif
+	FMovementTimings::Samples[(int32)EMovementTimer::CharacterSpawn] = MoveTemp(characterSpawnSamples);
+
+	TSharedPtr<FJsonObject> result = MakeShared<FJsonObject>();
+	result->SetNumberField(TEXT("Characters"), characters.Num());
+	if (bUseCourse)
+		result->SetStringField(TEXT("CourseHash"), FString::Printf(TEXT("%08x"), courseHash));
+	result->SetObjectField(TEXT("Frame"), MakeTimerResult(frameSamples));
+	for (int32 i = 0; i < (int32)EMovementTimer::Count; i++)
+		result->SetObjectField(FMovementTimings::GetName((EMovementTimer)i), MakeTimerResult(FMovementTimings::Samples[i]));
+	// 0 when the input moves the character in the frame it was read
+	result->SetObjectField(TEXT("InputLatencyFrames"), MakeTimerResult(FMovementTimings::InputLatencyFrames));
+	FMovementTimings::Reset();
+
+#if !UE_BUILD_SHIPPING
+	if (bCheckAllocations)
+	{
+		TSharedPtr<FJsonObject> allocations = MakeShared<FJsonObject>();
+		for (int32 i = 0; i < (int32)EMovementTimer::Count; i++)
+		{
+			const int32 count = FMovementAllocationTracker::Counts[i];
+			allocations->SetNumberField(FMovementTimings::GetName((EMovementTimer)i), count);
+			// spawning is allowed to allocate, the mesh tick is mostly engine code
+			if (count > 0 && (EMovementTimer)i != EMovementTimer::CharacterSpawn && (EMovementTimer)i != EMovementTimer::AnimTick)
+			{
+				UE_LOG(LogMovementMechanics, Error, TEXT("%d characters: %d allocations in %s"), CharacterCount, count, FMovementTimings::GetName((EMovementTimer)i));
+				AllocationFailures += count;
+			}
+		}
+		result->SetObjectField(TEXT("Allocations"), allocations);
+	}
+#endif
+
+	MovementSimulation::DestroyWorld(world);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("MovementBenchmark finished %d characters"), CharacterCount);
+	return result;
+}
+
+TSharedPtr<FJsonObject> UMovementBenchmarkCommandlet::RunPickUpCase(UWorld* TemplateWorld, int32 CharacterCount, bool bUseProximitySubsystem)
+{
+	UWorld* world = MovementSimulation::CreateWorld(TemplateWorld, CharacterCount);
+	const FTransform spawnTransform = MovementSimulation::FindSpawnTransform(world);
+	TArray<AMovementMechanicsCharacter*> characters;
+	SpawnCharacters(world, CharacterCount, spawnTransform, characters);
+
+	// scattered over the area the characters run through, at the height of their capsules
+	const float areaSize = FMath::CeilToInt(FMath::Sqrt((float)CharacterCount)) * SpawnSpacing + 4000.0f;
+	FRandomStream random(PickUps);
+	TArray<UTP_PickUpComponent*> pickUps;
+	pickUps.Reserve(PickUps);
+	const uint64 memoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+	for (int32 i = 0; i < PickUps; i++)
+	{
+		const FVector location = spawnTransform.GetLocation() + FVector(random.FRandRange(-0.5f, 0.5f) * areaSize, random.FRandRange(-0.5f, 0.5f) * areaSize, 0.0f);
+		AActor* actor = world->SpawnActor<AActor>(AActor::StaticClass(), FTransform(location));
+		if (!actor)
+			continue;
+		UTP_PickUpComponent* pickUp = NewObject<UTP_PickUpComponent>(actor);
+		pickUp->bUseProximitySubsystem = bUseProximitySubsystem;
+		// overlaps the capsules like a trigger sphere
+		pickUp->SetCollisionProfileName(TEXT("OverlapAllDynamic"));
+		pickUp->SetGenerateOverlapEvents(true);
+		actor->SetRootComponent(pickUp);
+		pickUp->SetWorldLocation(location);
+		// begins play as it registers, the subsystem takes it from there
+		pickUp->RegisterComponent();
+		pickUps.Add(pickUp);
+	}
+	const uint64 memoryAfter = FPlatformMemory::GetStats().UsedPhysical;
+
+	UPickUpProximitySubsystem* proximity = world->GetSubsystem<UPickUpProximitySubsystem>();
+	const SIZE_T hashBytes = proximity ? proximity->GetAllocatedSize() : 0;
+	float maxRadius = 0.0f;
+	for (UTP_PickUpComponent* pickUp : pickUps)
+		maxRadius = FMath::Max(maxRadius, pickUp->GetScaledSphereRadius());
+
+	TArray<double> frameSamples;
+	TArray<double> pairSamples;
+	TArray<FOverlapResult> overlaps;
+	for (float time = 0.0f; time < Duration; time += Timestep)
+	{
+		for (int32 i = 0; i < characters.Num(); i++)
+			DriveCharacter(characters[i], i, time);
+
+		FApp::SetDeltaTime(Timestep);
+		const double frameStart = FPlatformTime::Seconds();
+		world->Tick(LEVELTICK_All, Timestep);
+		frameSamples.Add((FPlatformTime::Seconds() - frameStart) * 1000000.0);
+		GFrameCounter++;
+
+		// outside the frame time, the pick up bodies whose bounds touch a capsule are the pairs the overlap
+		// updates of the moving capsules test
+		int32 pairs = 0;
+		if (bUseProximitySubsystem)
+			pairs = proximity ? proximity->GetLastTestCount() : 0;
+		else
+		{
+			for (AMovementMechanicsCharacter* character : characters)
+			{
+				UCapsuleComponent* capsule = character->GetCapsuleComponent();
+				const FBox bounds = capsule->Bounds.GetBox();
+				overlaps.Reset();
+				world->OverlapMultiByObjectType(overlaps, bounds.GetCenter(), FQuat::Identity, FCollisionObjectQueryParams(ECC_WorldDynamic),
+					FCollisionShape::MakeBox(bounds.GetExtent()), FCollisionQueryParams(SCENE_QUERY_STAT(PickUpPairs), false, character));
+				for (const FOverlapResult& overlap : overlaps)
+				{
+					if (Cast<UTP_PickUpComponent>(overlap.GetComponent()))
+						pairs++;
+				}
+			}
+		}
+		pairSamples.Add(pairs);
+	}
+
+	int32 physicsBodies = 0;
+	for (UTP_PickUpComponent* pickUp : pickUps)
+	{
+		if (IsValid(pickUp) && pickUp->IsCollisionEnabled())
+			physicsBodies++;
+	}
+
+	TSharedPtr<FJsonObject> result = MakeShared<FJsonObject>();
+	result->SetNumberField(TEXT("Characters"), characters.Num());
+	result->SetObjectField(TEXT("Frame"), MakeTimerResult(frameSamples));
+	result->SetObjectField(TEXT("PairsPerFrame"), MakeTimerResult(pairSamples));
+	result->SetNumberField(TEXT("PhysicsBodies"), physicsBodies);
+	result->SetNumberField(TEXT("SpawnMemoryBytes"), (double)(memoryAfter > memoryBefore ? memoryAfter - memoryBefore : 0));
+	result->SetNumberField(TEXT("HashBytes"), (double)hashBytes);
+
+	MovementSimulation::DestroyWorld(world);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("MovementBenchmark finished %d characters among %d pick ups with %s"), CharacterCount, PickUps,
+		bUseProximitySubsystem ? TEXT("the proximity subsystem") : TEXT("overlap spheres"));
+	return result;
+}
+
+TSharedPtr<FJsonObject> UMovementBenchmarkCommandlet::RunWallRunCase(UWorld* TemplateWorld, int32 CharacterCount, bool bCacheWallPlane)
+{
+	UWorld* world = MovementSimulation::CreateWorld(TemplateWorld, CharacterCount);
+	const FTransform spawnTransform = MovementSimulation::FindSpawnTransform(world);
+	const uint32 courseHash = SpawnCourse(world, spawnTransform);
+	TArray<AMovementMechanicsCharacter*> characters;
+	SpawnCharacters(world, CharacterCount, spawnTransform, characters);
+	for (AMovementMechanicsCharacter* character : characters)
+		character->bCacheWallPlane = bCacheWallPlane;
+
+	TArray<double> frameSamples;
+	TArray<double> traceSamples;
+	TArray<double> lengthSamples;
+	TArray<float> wallRunStarts;
+	wallRunStarts.Init(-1.0f, characters.Num());
+	double traces = 0.0;
+	double wallRunSeconds = 0.0;
+	for (float time = 0.0f; time < Duration; time += Timestep)
+	{
+		for (int32 i = 0; i < characters.Num(); i++)
+			DriveCharacter(characters[i], i, time);
+
+		FApp::SetDeltaTime(Timestep);
+		const double frameStart = FPlatformTime::Seconds();
+		world->Tick(LEVELTICK_All, Timestep);
+		frameSamples.Add((FPlatformTime::Seconds() - frameStart) * 1000000.0);
+		GFrameCounter++;
+
+		// a wall run that ended this frame left its trace count on the character
+		for (int32 i = 0; i < characters.Num(); i++)
+		{
+			const bool wallRunning = characters[i]->IsWallRunning();
+			if (wallRunning && wallRunStarts[i] < 0.0f)
+				wallRunStarts[i] = time;
+			else if (!wallRunning && wallRunStarts[i] >= 0.0f)
+			{
+				traceSamples.Add(characters[i]->GetLastWallRunTraceCount());
+				lengthSamples.Add(time - wallRunStarts[i]);
+				traces += traceSamples.Last();
+				wallRunSeconds += lengthSamples.Last();
+				wallRunStarts[i] = -1.0f;
+			}
+		}
+	}
+
+	TSharedPtr<FJsonObject> result = MakeShared<FJsonObject>();
+	result->SetNumberField(TEXT("Characters"), characters.Num());
+	if (bUseCourse)
+		result->SetStringField(TEXT("CourseHash"), FString::Printf(TEXT("%08x"), courseHash));
+	result->SetNumberField(TEXT("WallRuns"), traceSamples.Num());
+	result->SetNumberField(TEXT("TracesPerSecond"), wallRunSeconds > 0.0 ? traces / wallRunSeconds : 0.0);
+	result->SetObjectField(TEXT("Frame"), MakeTimerResult(frameSamples));
+	result->SetObjectField(TEXT("TracesPerWallRun"), MakeTimerResult(traceSamples));
+	// the cached plane has to end the runs where the traced one does, a longer run is running on air
+	result->SetObjectField(TEXT("WallRunSeconds"), MakeTimerResult(lengthSamples));
+
+	MovementSimulation::DestroyWorld(world);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("MovementBenchmark finished %d characters %s, %d wall runs, %.1f traces per wall run"), CharacterCount,
+		bCacheWallPlane ? TEXT("with the cached wall plane") : TEXT("tracing the wall every frame"), traceSamples.Num(), traces / FMath::Max(traceSamples.Num(), 1));
+	return result;
+}
+
+uint32 UMovementBenchmarkCommandlet::SpawnCourse(UWorld* World, const FTransform& SpawnTransform)
+{
+	if (!bUseCourse)
+		return 0;
+
+	// the course starts at the characters and runs the way they face, the player start is half a capsule above the floor
+	FTransform courseTransform(FRotator(0.0f, SpawnTransform.Rotator().Yaw, 0.0f), SpawnTransform.GetLocation() - FVector(0.0f, 0.0f, 96.0f));
+	AMovementStressCourse* course = World->SpawnActor<AMovementStressCourse>(AMovementStressCourse::StaticClass(), courseTransform);
+	if (!course)
+		return 0;
+	course->Seed = CourseSeed;
+	course->Generate();
+	return course->GetCourseHash();
+}
+
+void UMovementBenchmarkCommandlet::SpawnCharacters(UWorld* World, int32 CharacterCount, const FTransform& SpawnTransform, TArray<AMovementMechanicsCharacter*>& OutCharacters)
+{
+	const int32 gridSize = FMath::CeilToInt(FMath::Sqrt((float)CharacterCount));
+	for (int32 i = 0; i < CharacterCount; i++)
+	{
+		FTransform transform = SpawnTransform;
+		transform.AddToTranslation(FVector((i % gridSize) * SpawnSpacing, (i / gridSize) * SpawnSpacing, 0.0f));
+		if (AMovementMechanicsCharacter* character = MovementSimulation::SpawnScriptedCharacter(World, PawnClassName, transform))
+		{
+			character->ForceMovementPolicy(Policy);
+			OutCharacters.Add(character);
+		}
+	}
+}
+
+void UMovementBenchmarkCommandlet::DriveCharacter(AMovementMechanicsCharacter* Character, int32 Index, float Time)
+{
+	const int32 frame = FMath::FloorToInt(Time / Timestep);
+	const int32 offset = Index * 7;
+
+	Character->SetScriptedAxes(1.0f, 0.0f);
+
+	// jump every second, grapple every three seconds, each character offset so they don't all act on the same frame
+	const int32 jumpFrames = FMath::Max(FMath::RoundToInt(1.0f / Timestep), 1);
+	const int32 grappleFrames = FMath::Max(FMath::RoundToInt(3.0f / Timestep), 1);
+	if ((frame + offset) % jumpFrames == 0)
+		Character->ScriptedJump();
+	if ((frame + offset) % grappleFrames == 0)
+		Character->ScriptedGrapple();
+
+	// turn slowly so the characters keep finding new walls
+	if (AController* controller = Character->GetController())
+		controller->SetControlRotation(controller->GetControlRotation() + FRotator(0.0f, 30.0f * Timestep, 0.0f));
+}
+
+int32 UMovementBenchmarkCommandlet::CompareWithBaseline(const TSharedPtr<FJsonObject>& Results, const FString& BaselinePath)
+{
+	FString baselineString;
+	TSharedPtr<FJsonObject> baseline;
+	if (!FFileHelper::LoadFileToString(baselineString, *BaselinePath) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(baselineString), baseline) || !baseline.IsValid())
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Could not read baseline %s"), *BaselinePath);
+		return 1;
+	}
+
+	const TSharedPtr<FJsonObject>* baselineCases;
+	if (!baseline->TryGetObjectField(TEXT("Cases"), baselineCases))
+		return 0;
+
+	int32 regressions = 0;
+	for (const auto& caseEntry : Results->GetObjectField(TEXT("Cases"))->Values)
+	{
+		const TSharedPtr<FJsonObject>* baselineCase;
+		if (!(*baselineCases)->TryGetObjectField(caseEntry.Key, baselineCase))
+			continue;
+
+		for (const auto& timerEntry : caseEntry.Value->AsObject()->Values)
+		{
+			const TSharedPtr<FJsonObject>* currentTimer;
+			const TSharedPtr<FJsonObject>* baselineTimer;
+			if (!timerEntry.Value->TryGetObject(currentTimer) || !(*baselineCase)->TryGetObjectField(timerEntry.Key, baselineTimer))
+				continue;
+
+			// counted in frames and usually 0, any extra frame is a regression
+			if (timerEntry.Key == TEXT("InputLatencyFrames"))
+			{
+				double current = (*currentTimer)->GetNumberField(TEXT("P99"));
+				double previous = (*baselineTimer)->GetNumberField(TEXT("P99"));
+				if (current > previous)
+				{
+					UE_LOG(LogMovementMechanics, Error, TEXT("%s characters InputLatencyFrames P99: %.0f frames, baseline %.0f frames"), *caseEntry.Key, current, previous);
+					regressions++;
+				}
+				continue;
+			}
+
+			for (const TCHAR* field : { TEXT("Mean"), TEXT("P99") })
+			{
+				double current = (*currentTimer)->GetNumberField(field);
+				double previous = (*baselineTimer)->GetNumberField(field);
+				if (previous > 0.0 && current > previous * (1.0 + Threshold))
+				{
+					UE_LOG(LogMovementMechanics, Error, TEXT("%s characters %s %s: %.2fus, baseline %.2fus"), *caseEntry.Key, *timerEntry.Key, field, current, previous);
+					regressions++;
+				}
+			}
+		}
+	}
+	return regressions;
+}
+
+TSharedPtr<FJsonObject> UMovementBenchmarkCommandlet::MakeTimerResult(TArray<double>& Samples)
+{
+	TSharedPtr<FJsonObject> result = MakeShared<FJsonObject>();
+	double mean = 0.0;
+	double p99 = 0.0;
+	if (Samples.Num() > 0)
+	{
+		for (double sample : Samples)
+			mean += sample;
+		mean /= Samples.Num();
+
+		Samples.Sort();
+		p99 = Samples[FMath::Min(FMath::FloorToInt(Samples.Num() * 0.99), Samples.Num() - 1)];
+	}
+	result->SetNumberField(TEXT("Calls"), Samples.Num());
+	result->SetNumberField(TEXT("Mean"), mean);
+	result->SetNumberField(TEXT("P99"), p99);
+	return result;
+}
@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementCollisionProxyGenerator.h"
+#include "MovementMechanicsStats.h"
+#include "MovementMechanicsCollision.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SphereComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "EngineUtils.h"
+#include "PhysicsEngine/BodySetup.h"
+
+const FName AMovementCollisionProxyGenerator::ProxyTag(TEXT("MovementProxy"));
+
+AMovementCollisionProxyGenerator::AMovementCollisionProxyGenerator()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+#if WITH_EDITORONLY_DATA
+	bIsEditorOnlyActor = true;
+#endif
+}
+
+#if WITH_EDITOR
+namespace
+{
+	void AddProxy(AActor* Actor, UStaticMeshComponent* MeshComponent, UShapeComponent* Proxy, const FTransform& Transform)
+	{
+		Proxy->ComponentTags.Add(AMovementCollisionProxyGenerator::ProxyTag);
+		Proxy->SetupAttachment(MeshComponent);
+		Proxy->SetRelativeTransform(Transform);
+		Proxy->SetCollisionProfileName(MOVEMENT_PROXY_PROFILE);
+		Proxy->SetGenerateOverlapEvents(false);
+		Proxy->CanCharacterStepUpOn = ECB_No;
+		Actor->AddInstanceComponent(Proxy);
+		Proxy->RegisterComponent();
+	}
+}
+#endif
+
+void AMovementCollisionProxyGenerator::GenerateProxies()
+{
+#if WITH_EDITOR
+	int32 generated = 0;
+	for (TActorIterator<AStaticMeshActor> it(GetWorld()); it; ++it)
+	{
+		AStaticMeshActor* actor = *it;
+		UStaticMeshComponent* meshComponent = actor->GetStaticMeshComponent();
+		UStaticMesh* mesh = meshComponent ? meshComponent->GetStaticMesh() : nullptr;
+		if (!mesh)
+			continue;
+
+		const FString meshPath = mesh->GetPathName();
+		if (!MeshPaths.ContainsByPredicate([&meshPath](const FString& path) { return meshPath.StartsWith(path); }))
+			continue;
+
+		// already done
+		if (actor->Tags.Contains(ProxyTag))
+			continue;
+
+		const FBox bounds = mesh->GetBoundingBox();
+		const FVector scaledSize = bounds.GetSize() * meshComponent->GetComponentScale().GetAbs();
+		const bool clutter = scaledSize.GetMax() < MinProxySize;
+
+		// only shapes a proxy component can copy exactly
+		UBodySetup* bodySetup = mesh->GetBodySetup();
+		if (!clutter)
+		{
+			if (!bodySetup || bodySetup->AggGeom.ConvexElems.Num() > 0 || bodySetup->AggGeom.TaperedCapsuleElems.Num() > 0
+				|| bodySetup->AggGeom.BoxElems.Num() + bodySetup->AggGeom.SphereElems.Num() + bodySetup->AggGeom.SphylElems.Num() == 0)
+				continue;
+		}
+
+		actor->Modify();
+		meshComponent->Modify();
+		// RemoveProxies restores every tagged actor, clutter included
+		actor->Tags.Add(ProxyTag);
+		// the mesh is no longer tested by the movement traces
+		meshComponent->SetCollisionResponseToChannel(ECC_WallRun, ECR_Ignore);
+		meshComponent->SetCollisionResponseToChannel(ECC_Grapple, ECR_Ignore);
+		if (clutter)
+			continue;
+
+		for (const FKBoxElem& elem : bodySetup->AggGeom.BoxElems)
+		{
+			UBoxComponent* proxy = NewObject<UBoxComponent>(actor, NAME_None, RF_Transactional);
+			proxy->SetBoxExtent(FVector(elem.X, elem.Y, elem.Z) * 0.5f, false);
+			AddProxy(actor, meshComponent, proxy, elem.GetTransform());
+			generated++;
+		}
+		for (const FKSphereElem& elem : bodySetup->AggGeom.SphereElems)
+		{
+			USphereComponent* proxy = NewObject<USphereComponent>(actor, NAME_None, RF_Transactional);
+			proxy->SetSphereRadius(elem.Radius, false);
+			AddProxy(actor, meshComponent, proxy, elem.GetTransform());
+			generated++;
+		}
+		for (const FKSphylElem& elem : bodySetup->AggGeom.SphylElems)
+		{
+			UCapsuleComponent* proxy = NewObject<UCapsuleComponent>(actor, NAME_None, RF_Transactional);
+			proxy->SetCapsuleSize(elem.Radius, elem.Length * 0.5f + elem.Radius, false);
+			AddProxy(actor, meshComponent, proxy, elem.GetTransform());
+			generated++;
+		}
+	}
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("Generated %d movement collision proxies"), generated);
+#endif
+}
+
+void AMovementCollisionProxyGenerator::RemoveProxies()
+{
+#if WITH_EDITOR
+	int32 removed = 0;
+	for (TActorIterator<AStaticMeshActor> it(GetWorld()); it; ++it)
+	{
+		AStaticMeshActor* actor = *it;
+		if (!actor->Tags.Contains(ProxyTag))
+			continue;
+
+		actor->Modify();
+		actor->Tags.Remove(ProxyTag);
+		TArray<UShapeComponent*> shapes;
+		actor->GetComponents(shapes);
+		for (UShapeComponent* shape : shapes)
+		{
+			if (!shape->ComponentHasTag(ProxyTag))
+				continue;
+
+			actor->RemoveInstanceComponent(shape);
+			shape->DestroyComponent();
+			removed++;
+		}
+
+		// the mesh answers the movement traces again
+		if (UStaticMeshComponent* meshComponent = actor->GetStaticMeshComponent())
+		{
+			meshComponent->Modify();
+			meshComponent->SetCollisionResponseToChannel(ECC_WallRun, ECR_Block);
+			meshComponent->SetCollisionResponseToChannel(ECC_Grapple, ECR_Block);
+		}
+	}
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("Removed %d movement collision proxies"), removed);
+#endif
+}
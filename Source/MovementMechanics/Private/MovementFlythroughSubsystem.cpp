@@ -0,0 +1,205 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementFlythroughSubsystem.h"
+#include "MovementMechanicsCharacter.h"
+#include "MovementMechanicsStats.h"
+#include "GrapplingHookComponent.h"
+#include "Camera/CameraComponent.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonSerializer.h"
+#include "UObject/UObjectGlobals.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
+
+bool UMovementFlythroughSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	FString output;
+	return FParse::Value(FCommandLine::Get(), TEXT("MovementFlythrough="), output) && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UMovementFlythroughSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FParse::Value(FCommandLine::Get(), TEXT("MovementFlythrough="), OutputPath);
+	FParse::Value(FCommandLine::Get(), TEXT("FlythroughSpeed="), Speed);
+	FParse::Value(FCommandLine::Get(), TEXT("FlythroughLeg="), LegLength);
+	FParse::Value(FCommandLine::Get(), TEXT("FlythroughLegs="), Legs);
+	FParse::Value(FCommandLine::Get(), TEXT("FlythroughGrappleTime="), GrappleTime);
+	FParse::Value(FCommandLine::Get(), TEXT("FlythroughGrapplePitch="), GrapplePitch);
+	FParse::Value(FCommandLine::Get(), TEXT("FlythroughHitchMs="), HitchMs);
+	bPredictiveStreaming = !FParse::Param(FCommandLine::Get(), TEXT("NoPredictiveStreaming"));
+}
+
+void UMovementFlythroughSubsystem::Tick(float DeltaTime)
+{
+	LLM_SCOPE_BYTAG(MovementSubsystems);
+	if (!GetWorld()->IsGameWorld() || bFinished)
+		return;
+
+	if (!Character.IsValid() && !StartFlythrough())
+		return;
+
+	SampleStreaming(DeltaTime);
+
+	// the cable moves the character on the grapple leg
+	if (bGrappleLeg)
+	{
+		TickGrappleLeg(DeltaTime);
+		return;
+	}
+
+	// fly by velocity so the character's own movement, and the velocity the streaming sources read, stay real
+	const float step = Speed * DeltaTime;
+	LegDistance += step;
+	if (LegDistance >= LegLength)
+	{
+		LegDistance = 0.0f;
+		Direction = Direction.RotateAngleAxis(90.0f, FVector::UpVector);
+		if (++Leg >= Legs)
+		{
+			if (!StartGrappleLeg())
+				FinishFlythrough();
+			return;
+		}
+	}
+	Character->GetCharacterMovement()->Velocity = Direction * Speed;
+	if (AController* controller = Character->GetController())
+		controller->SetControlRotation(Direction.Rotation());
+}
+
+TStatId UMovementFlythroughSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMovementFlythroughSubsystem, STATGROUP_Tickables);
+}
+
+bool UMovementFlythroughSubsystem::StartFlythrough()
+{
+	APlayerController* controller = GetWorld()->GetFirstPlayerController();
+	AMovementMechanicsCharacter* character = controller ? Cast<AMovementMechanicsCharacter>(controller->GetPawn()) : nullptr;
+	if (!character)
+		return false;
+
+	// the route goes through whatever is in the way, only streaming is measured
+	character->ForceMovementPolicy(EMovementPolicy::Bot);
+	character->SetActorEnableCollision(false);
+	character->bPredictiveStreaming = bPredictiveStreaming;
+	UCharacterMovementComponent* movement = character->GetCharacterMovement();
+	movement->SetMovementMode(MOVE_Flying);
+	movement->MaxFlySpeed = Speed;
+	movement->BrakingDecelerationFlying = 0.0f;
+
+	Direction = character->GetActorForwardVector().GetSafeNormal2D();
+	Character = character;
+	UE_LOG(LogMovementMechanics, Display, TEXT("Flythrough started at %.0f cm/s, predictive streaming %s"), Speed, bPredictiveStreaming ? TEXT("on") : TEXT("off"));
+	return true;
+}
+
+void UMovementFlythroughSubsystem::SampleStreaming(float DeltaTime)
+{
+	UWorldPartitionSubsystem* worldPartition = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>();
+	if (!worldPartition)
+		return;
+
+	// the cells the player needs right now, using each grid's loading range
+	TArray<FWorldPartitionStreamingQuerySource> querySources;
+	querySources.Emplace(Character->GetActorLocation());
+	const bool stalled = !worldPartition->IsStreamingCompleted(EWorldPartitionRuntimeCellState::Activated, querySources, false);
+
+	Frames++;
+	if (stalled)
+	{
+		StallFrames++;
+		StallSeconds += DeltaTime;
+		if (!bStalled)
+			Stalls++;
+		if (bGrappleLeg)
+			GrappleStallFrames++;
+	}
+	bStalled = stalled;
+
+	const float frameMs = DeltaTime * 1000.0f;
+	MaxFrameMs = FMath::Max(MaxFrameMs, frameMs);
+	if (frameMs > HitchMs && (IsAsyncLoading() || stalled))
+		BlockingLoads++;
+}
+
+bool UMovementFlythroughSubsystem::StartGrappleLeg()
+{
+	if (GrappleTime <= 0.0f || !Character->GrappleHookComponent)
+		return false;
+
+	// the player aims with the control rotation, the camera is set too in case it has not followed it yet this frame
+	const FRotator aim = Direction.Rotation() + FRotator(GrapplePitch, 0.0f, 0.0f);
+	if (AController* controller = Character->GetController())
+		controller->SetControlRotation(aim);
+	Character->GetFirstPersonCameraComponent()->SetWorldRotation(aim);
+	Character->ScriptedGrapple();
+
+	bGrappleLeg = true;
+	GrappleLegTime = 0.0f;
+	return true;
+}
+
+void UMovementFlythroughSubsystem::TickGrappleLeg(float DeltaTime)
+{
+	GrappleLegTime += DeltaTime;
+
+	UGrapplingHookComponent* hook = Character->GrappleHookComponent;
+	if (hook->IsInUse())
+	{
+		GrappleFrames++;
+		TArray<FWorldPartitionStreamingSource> sources;
+		Character->GetStreamingSources(sources);
+		if (sources.ContainsByPredicate([](const FWorldPartitionStreamingSource& Source) { return Source.Priority == EStreamingSourcePriority::High; }))
+			GrappleSourceFrames++;
+	}
+	else if (GrappleFrames > 0)
+	{
+		// released at the anchor or swung past it
+		FinishFlythrough();
+		return;
+	}
+
+	if (GrappleLegTime >= GrappleTime)
+	{
+		if (GrappleFrames == 0)
+			UE_LOG(LogMovementMechanics, Warning, TEXT("Flythrough grapple hit nothing within %.0f cm"), Character->GrappleRayLength);
+		if (hook->IsInUse())
+			hook->DetachGrapple();
+		FinishFlythrough();
+	}
+}
+
+void UMovementFlythroughSubsystem::FinishFlythrough()
+{
+	bFinished = true;
+	UE_LOG(LogMovementMechanics, Display, TEXT("Flythrough: %d frames, %d stalls (%d frames, %.2fs), %d blocking loads, %.1fms longest frame, %d grapple frames (%d stalled)"),
+		Frames, Stalls, StallFrames, StallSeconds, BlockingLoads, MaxFrameMs, GrappleFrames, GrappleStallFrames);
+
+	TSharedPtr<FJsonObject> results = MakeShared<FJsonObject>();
+	results->SetBoolField(TEXT("PredictiveStreaming"), bPredictiveStreaming);
+	results->SetNumberField(TEXT("Speed"), Speed);
+	results->SetNumberField(TEXT("Distance"), LegLength * Legs);
+	results->SetNumberField(TEXT("Frames"), Frames);
+	results->SetNumberField(TEXT("Stalls"), Stalls);
+	results->SetNumberField(TEXT("StallFrames"), StallFrames);
+	results->SetNumberField(TEXT("StallSeconds"), StallSeconds);
+	results->SetNumberField(TEXT("BlockingLoads"), BlockingLoads);
+	results->SetNumberField(TEXT("MaxFrameMs"), MaxFrameMs);
+	results->SetNumberField(TEXT("GrappleFrames"), GrappleFrames);
+	results->SetNumberField(TEXT("GrappleSourceFrames"), GrappleSourceFrames);
+	results->SetNumberField(TEXT("GrappleStallFrames"), GrappleStallFrames);
+
+	FString json;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+	FJsonSerializer::Serialize(results.ToSharedRef(), writer);
+	const bool written = FFileHelper::SaveStringToFile(json, *OutputPath);
+	if (!written)
+		UE_LOG(LogMovementMechanics, Error, TEXT("Could not write flythrough results to %s"), *OutputPath);
+	FPlatformMisc::RequestExitWithStatus(false, written ? 0 : 1);
+}
@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementFrameRateCommandlet.h"
+#include "MovementMechanicsStats.h"
+#include "MovementSimulation.h"
+#include "MovementMechanicsCharacter.h"
+#include "GrapplingHookComponent.h"
+#include "Engine/World.h"
+#include "Misc/App.h"
+
+UMovementFrameRateCommandlet::UMovementFrameRateCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UMovementFrameRateCommandlet::Main(const FString& Params)
+{
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Pawn="), PawnClassName);
+	FParse::Value(*Params, TEXT("Reference="), ReferenceRate);
+	FParse::Value(*Params, TEXT("Duration="), Duration);
+	FParse::Value(*Params, TEXT("PositionTolerance="), PositionTolerance);
+	FParse::Value(*Params, TEXT("WallRunTolerance="), WallRunTolerance);
+	FParse::Value(*Params, TEXT("AttachTolerance="), AttachTolerance);
+
+	FString ratesString;
+	if (FParse::Value(*Params, TEXT("Rates="), ratesString, false))
+	{
+		TArray<FString> rates;
+		ratesString.ParseIntoArray(rates, TEXT(","));
+		Rates.Reset();
+		for (const FString& rate : rates)
+			Rates.Add(FCString::Atoi(*rate));
+	}
+	Rates.AddUnique(ReferenceRate);
+	for (int32 rate : Rates)
+	{
+		if (rate <= 0 || rate % 10 != 0)
+		{
+			UE_LOG(LogMovementMechanics, Error, TEXT("MovementFrameRate: %d Hz is not a multiple of 10"), rate);
+			return 1;
+		}
+	}
+
+	UWorld* templateWorld = MovementSimulation::LoadTemplateWorld(MapName);
+	if (!templateWorld)
+		return 1;
+
+	TArray<FFrameRateRun> runs;
+	int32 worldIndex = 0;
+	for (int32 rate : Rates)
+	{
+		FFrameRateRun& run = runs.AddDefaulted_GetRef();
+		if (!Run(templateWorld, rate, worldIndex++, run))
+			return 1;
+	}
+
+	const FFrameRateRun* reference = runs.FindByPredicate([this](const FFrameRateRun& Run) { return Run.Rate == ReferenceRate; });
+	int32 failures = 0;
+	for (const FFrameRateRun& run : runs)
+	{
+		if (&run != reference)
+			failures += Compare(*reference, run);
+	}
+
+	if (failures > 0)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("MovementFrameRate: %d differences beyond the tolerances"), failures);
+		return 1;
+	}
+	UE_LOG(LogMovementMechanics, Display, TEXT("MovementFrameRate: %d rates match %d Hz"), Rates.Num() - 1, ReferenceRate);
+	return 0;
+}
+
+bool UMovementFrameRateCommandlet::Run(UWorld* TemplateWorld, int32 Rate, int32 WorldIndex, FFrameRateRun& OutRun)
+{
+	const float timestep = 1.0f / Rate;
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(timestep);
+
+	UWorld* world = MovementSimulation::CreateWorld(TemplateWorld, WorldIndex);
+	AMovementMechanicsCharacter* character = MovementSimulation::SpawnScriptedCharacter(world, PawnClassName, MovementSimulation::FindSpawnTransform(world));
+	if (!character)
+	{
+		MovementSimulation::DestroyWorld(world);
+		return false;
+	}
+
+	OutRun.Rate = Rate;
+	const int32 frames = FMath::RoundToInt(Duration * Rate);
+	const int32 framesPerSample = Rate / 10;
+	int32 wallRunStartFrame = -1;
+	bool attached = false;
+	for (int32 frame = 0; frame < frames; frame++)
+	{
+		DriveCharacter(character, frame, Rate);
+		FApp::SetDeltaTime(timestep);
+		world->Tick(LEVELTICK_All, timestep);
+		GFrameCounter++;
+
+		if ((frame + 1) % framesPerSample == 0)
+			OutRun.Trajectory.Add(character->GetActorLocation());
+
+		const bool wallRunning = character->IsWallRunning();
+		if (wallRunning && wallRunStartFrame < 0)
+			wallRunStartFrame = frame;
+		else if (!wallRunning && wallRunStartFrame >= 0)
+		{
+			OutRun.WallRunDurations.Add((frame - wallRunStartFrame) * timestep);
+			wallRunStartFrame = -1;
+		}
+
+		// the hook is the anchor on the frame it attaches, before the cable wraps
+		const bool grappleAttached = character->GrappleHookComponent && character->GrappleHookComponent->IsGrappleAttached();
+		if (grappleAttached && !attached)
+			OutRun.AttachPoints.Add(character->GrappleHookComponent->GetCableAnchor());
+		attached = grappleAttached;
+	}
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("%d Hz: %d wall runs, %d grapples, ended at %s"), Rate, OutRun.WallRunDurations.Num(), OutRun.AttachPoints.Num(),
+		*character->GetActorLocation().ToString());
+
+	MovementSimulation::DestroyWorld(world);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	return true;
+}
+
+void UMovementFrameRateCommandlet::DriveCharacter(AMovementMechanicsCharacter* Character, int32 Frame, int32 Rate)
+{
+	Character->SetScriptedAxes(1.0f, 0.0f);
+	if (Frame % Rate == 0)
+		Character->ScriptedJump();
+	if (Frame % (Rate * 3) == Rate * 3 / 2)
+		Character->ScriptedGrapple();
+	if (AController* controller = Character->GetController())
+		controller->SetControlRotation(controller->GetControlRotation() + FRotator(0.0f, 30.0f / Rate, 0.0f));
+}
+
+int32 UMovementFrameRateCommandlet::Compare(const FFrameRateRun& Reference, const FFrameRateRun& Run) const
+{
+	int32 failures = 0;
+
+	float maxError = 0.0f;
+	int32 maxErrorSample = 0;
+	for (int32 i = 0; i < FMath::Min(Reference.Trajectory.Num(), Run.Trajectory.Num()); i++)
+	{
+		const float error = FVector::Distance(Reference.Trajectory[i], Run.Trajectory[i]);
+		if (error > maxError)
+		{
+			maxError = error;
+			maxErrorSample = i;
+		}
+	}
+	if (maxError > PositionTolerance)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("%d Hz: %.1fcm from %d Hz at %.1fs"), Run.Rate, maxError, Reference.Rate, (maxErrorSample + 1) * 0.1f);
+		failures++;
+	}
+
+	if (Run.WallRunDurations.Num() != Reference.WallRunDurations.Num())
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("%d Hz: %d wall runs, %d at %d Hz"), Run.Rate, Run.WallRunDurations.Num(), Reference.WallRunDurations.Num(), Reference.Rate);
+		failures++;
+	}
+	else
+	{
+		for (int32 i = 0; i < Run.WallRunDurations.Num(); i++)
+		{
+			// a wall run can only end on a frame, allow one frame of the slower rate on top
+			const float tolerance = WallRunTolerance + 1.0f / FMath::Min(Run.Rate, Reference.Rate);
+			if (FMath::Abs(Run.WallRunDurations[i] - Reference.WallRunDurations[i]) > tolerance)
+			{
+				UE_LOG(LogMovementMechanics, Error, TEXT("%d Hz: wall run %d lasted %.3fs, %.3fs at %d Hz"), Run.Rate, i, Run.WallRunDurations[i], Reference.WallRunDurations[i], Reference.Rate);
+				failures++;
+			}
+		}
+	}
+
+	if (Run.AttachPoints.Num() != Reference.AttachPoints.Num())
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("%d Hz: %d grapples, %d at %d Hz"), Run.Rate, Run.AttachPoints.Num(), Reference.AttachPoints.Num(), Reference.Rate);
+		failures++;
+	}
+	else
+	{
+		for (int32 i = 0; i < Run.AttachPoints.Num(); i++)
+		{
+			const float error = FVector::Distance(Run.AttachPoints[i], Reference.AttachPoints[i]);
+			if (error > AttachTolerance)
+			{
+				UE_LOG(LogMovementMechanics, Error, TEXT("%d Hz: grapple %d attached %.1fcm from where it did at %d Hz"), Run.Rate, i, error, Reference.Rate);
+				failures++;
+			}
+		}
+	}
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("%d Hz: trajectory within %.1fcm of %d Hz"), Run.Rate, maxError, Reference.Rate);
+	return failures;
+}
@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementHitscanCommandlet.h"
+#include "MovementBenchmarkCommandlet.h"
+#include "MovementSimulation.h"
+#include "MovementMechanicsStats.h"
+#include "HitscanTraceSubsystem.h"
+#include "Engine/World.h"
+#include "Dom/JsonObject.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonSerializer.h"
+
+UMovementHitscanCommandlet::UMovementHitscanCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UMovementHitscanCommandlet::Main(const FString& Params)
+{
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Frames="), Frames);
+	FParse::Value(*Params, TEXT("Warmup="), WarmupFrames);
+	FParse::Value(*Params, TEXT("Range="), Range);
+	FParse::Value(*Params, TEXT("Timestep="), Timestep);
+	FString batchesString;
+	if (FParse::Value(*Params, TEXT("Batches="), batchesString, false))
+	{
+		TArray<FString> batches;
+		batchesString.ParseIntoArray(batches, TEXT(","));
+		BatchSizes.Reset();
+		for (const FString& batch : batches)
+			BatchSizes.Add(FCString::Atoi(*batch));
+	}
+
+	UWorld* templateWorld = MovementSimulation::LoadTemplateWorld(MapName);
+	if (!templateWorld)
+		return 1;
+
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(Timestep);
+
+	TSharedPtr<FJsonObject> results = MakeShared<FJsonObject>();
+	results->SetStringField(TEXT("Map"), MapName);
+	results->SetNumberField(TEXT("Frames"), Frames);
+	results->SetNumberField(TEXT("Range"), Range);
+	TSharedPtr<FJsonObject> batches = MakeShared<FJsonObject>();
+	for (int32 i = 0; i < BatchSizes.Num(); i++)
+	{
+		TSharedPtr<FJsonObject> batch = RunBatch(templateWorld, BatchSizes[i], i);
+		if (!batch.IsValid())
+			return 1;
+		batches->SetObjectField(FString::FromInt(BatchSizes[i]), batch);
+	}
+	results->SetObjectField(TEXT("Batches"), batches);
+
+	FString outputPath;
+	if (FParse::Value(*Params, TEXT("Output="), outputPath))
+	{
+		FString json;
+		TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+		FJsonSerializer::Serialize(results.ToSharedRef(), writer);
+		if (!FFileHelper::SaveStringToFile(json, *outputPath))
+		{
+			UE_LOG(LogMovementMechanics, Error, TEXT("Could not write %s"), *outputPath);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+TSharedPtr<FJsonObject> UMovementHitscanCommandlet::RunBatch(UWorld* TemplateWorld, int32 BatchSize, int32 WorldIndex)
+{
+	UWorld* world = MovementSimulation::CreateWorld(TemplateWorld, WorldIndex);
+	UHitscanTraceSubsystem* hitscan = world->GetSubsystem<UHitscanTraceSubsystem>();
+	if (!hitscan)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("MovementHitscan: no hitscan subsystem in %s"), *MapName);
+		MovementSimulation::DestroyWorld(world);
+		return nullptr;
+	}
+
+	auto tickWorld = [world, this]()
+	{
+		FApp::SetDeltaTime(Timestep);
+		const double start = FPlatformTime::Seconds();
+		world->Tick(LEVELTICK_All, Timestep);
+		GFrameCounter++;
+		return (FPlatformTime::Seconds() - start) * 1000000.0;
+	};
+
+	// the world on its own, also lets it settle
+	TArray<double> emptySamples;
+	for (int32 frame = 0; frame < WarmupFrames + Frames; frame++)
+	{
+		const double frameTime = tickWorld();
+		if (frame >= WarmupFrames)
+			emptySamples.Add(frameTime);
+	}
+	TSharedPtr<FJsonObject> emptyResult = UMovementBenchmarkCommandlet::MakeTimerResult(emptySamples);
+
+	const FVector origin = MovementSimulation::FindSpawnTransform(world).GetLocation();
+	FRandomStream random(BatchSize);
+	TArray<double> frameSamples;
+	int64 queued = 0;
+	int64 resolved = 0;
+	for (int32 frame = 0; frame < WarmupFrames + Frames; frame++)
+	{
+		const bool measured = frame >= WarmupFrames;
+		for (int32 i = 0; i < BatchSize; i++)
+		{
+			const FVector start = origin + FVector(random.FRandRange(-0.5f, 0.5f), random.FRandRange(-0.5f, 0.5f), random.FRandRange(-0.5f, 0.5f)) * SpreadSize;
+			hitscan->QueueShot(start, start + random.GetUnitVector() * Range, 0.0f, nullptr);
+		}
+		if (measured)
+			queued += BatchSize;
+
+		const double frameTime = tickWorld();
+		// the tick resolves the shots queued the frame before
+		if (measured && frame > WarmupFrames)
+			resolved += hitscan->GetLastResolvedCount();
+		if (measured)
+			frameSamples.Add(frameTime);
+	}
+	// the last batch is resolved by one more tick
+	tickWorld();
+	resolved += hitscan->GetLastResolvedCount();
+
+	MovementSimulation::DestroyWorld(world);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	if (resolved != queued)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("MovementHitscan: %d shots a frame, %lld queued and %lld resolved"), BatchSize, queued, resolved);
+		return nullptr;
+	}
+
+	// the traces are what the frames with shots spend on top of the empty ones
+	double shotTime = 0.0;
+	for (double sample : frameSamples)
+		shotTime += sample;
+	shotTime -= emptyResult->GetNumberField(TEXT("Mean")) * frameSamples.Num();
+	const double tracesPerMs = shotTime > 0.0 ? queued / (shotTime / 1000.0) : 0.0;
+
+	TSharedPtr<FJsonObject> result = UMovementBenchmarkCommandlet::MakeTimerResult(frameSamples);
+	result->SetObjectField(TEXT("Empty"), emptyResult);
+	result->SetNumberField(TEXT("Shots"), (double)queued);
+	result->SetNumberField(TEXT("TracesPerMs"), tracesPerMs);
+	UE_LOG(LogMovementMechanics, Display, TEXT("%d shots a frame: %.2fus mean %.2fus p99, %.2fus empty, %.0f traces per ms"), BatchSize,
+		result->GetNumberField(TEXT("Mean")), result->GetNumberField(TEXT("P99")), emptyResult->GetNumberField(TEXT("Mean")), tracesPerMs);
+	return result;
+}
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementInputBuffer.h"
+
+static_assert((FMovementInputBuffer::Capacity & (FMovementInputBuffer::Capacity - 1)) == 0, "the ring indices wrap with a mask");
+
+FMovementInputBuffer::FMovementInputBuffer()
+	: Head(0)
+	, Tail(0)
+{
+	for (double& time : PendingTimes)
+		time = -1.0;
+}
+
+bool FMovementInputBuffer::Push(EBufferedInput Input, double Time)
+{
+	const uint32 head = Head.load(std::memory_order_relaxed);
+	if (head - Tail.load(std::memory_order_acquire) >= Capacity)
+		return false;
+
+	Presses[head & (Capacity - 1)] = { Time, Input };
+	// publishes the press to the consumer
+	Head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+void FMovementInputBuffer::Drain()
+{
+	uint32 tail = Tail.load(std::memory_order_relaxed);
+	const uint32 head = Head.load(std::memory_order_acquire);
+	for (; tail != head; tail++)
+	{
+		const FPress& press = Presses[tail & (Capacity - 1)];
+		double& pending = PendingTimes[(int32)press.Input];
+		pending = FMath::Max(pending, press.Time);
+	}
+	// frees the slots for the producer
+	Tail.store(tail, std::memory_order_release);
+}
+
+bool FMovementInputBuffer::IsPending(EBufferedInput Input, double Now, float Window) const
+{
+	const double time = PendingTimes[(int32)Input];
+	return time >= 0.0 && time <= Now && Now - time <= Window;
+}
+
+void FMovementInputBuffer::Consume(EBufferedInput Input)
+{
+	PendingTimes[(int32)Input] = -1.0;
+}
+
+void FMovementInputBuffer::Reset()
+{
+	Drain();
+	for (double& time : PendingTimes)
+		time = -1.0;
+}
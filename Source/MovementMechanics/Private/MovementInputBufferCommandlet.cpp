@@ -0,0 +1,293 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementInputBufferCommandlet.h"
+#include "MovementMechanicsStats.h"
+#include "MovementInputBuffer.h"
+#include "MovementSimulation.h"
+#include "MovementMechanicsCharacter.h"
+#include "GrapplingHookComponent.h"
+#include "Async/Async.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Misc/App.h"
+
+UMovementInputBufferCommandlet::UMovementInputBufferCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UMovementInputBufferCommandlet::Main(const FString& Params)
+{
+	FParse::Value(*Params, TEXT("Presses="), Presses);
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Pawn="), PawnClassName);
+	FParse::Value(*Params, TEXT("Duration="), Duration);
+	FParse::Value(*Params, TEXT("Timestep="), Timestep);
+	// at least one press of each input
+	Presses = FMath::Max(Presses, 2);
+
+	const int32 failures = CheckWindows() + CheckThreadedPushes() + CheckCharacter();
+	if (failures > 0)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("MovementInputBuffer: %d checks failed"), failures);
+		return 1;
+	}
+	UE_LOG(LogMovementMechanics, Display, TEXT("MovementInputBuffer: all checks passed"));
+	return 0;
+}
+
+int32 UMovementInputBufferCommandlet::CheckWindows()
+{
+	int32 failures = 0;
+	auto check = [&failures](bool bPassed, const TCHAR* What)
+	{
+		if (!bPassed)
+		{
+			UE_LOG(LogMovementMechanics, Error, TEXT("Input buffer: %s"), What);
+			failures++;
+		}
+	};
+
+	FMovementInputBuffer buffer;
+	const float window = 0.15f;
+
+	// pressed 0.1s before the character could jump, still in the window
+	buffer.Push(EBufferedInput::Jump, 10.0);
+	buffer.Drain();
+	check(buffer.IsPending(EBufferedInput::Jump, 10.1, window), TEXT("a press inside the window is not pending"));
+	check(!buffer.IsPending(EBufferedInput::Grapple, 10.1, window), TEXT("a jump press is pending as a grapple"));
+	buffer.Consume(EBufferedInput::Jump);
+	check(!buffer.IsPending(EBufferedInput::Jump, 10.1, window), TEXT("a consumed press is still pending"));
+
+	// too early
+	buffer.Push(EBufferedInput::Jump, 20.0);
+	buffer.Drain();
+	check(!buffer.IsPending(EBufferedInput::Jump, 20.2, window), TEXT("a press outside the window is pending"));
+
+	// stamped ahead of the world, waits for it
+	buffer.Push(EBufferedInput::Grapple, 30.5);
+	buffer.Drain();
+	check(!buffer.IsPending(EBufferedInput::Grapple, 30.0, window), TEXT("a press in the future is pending"));
+	check(buffer.IsPending(EBufferedInput::Grapple, 30.6, window), TEXT("a press in the future is not pending once it is due"));
+
+	// the latest press wins
+	buffer.Reset();
+	buffer.Push(EBufferedInput::Jump, 41.0);
+	buffer.Push(EBufferedInput::Jump, 40.0);
+	buffer.Drain();
+	check(buffer.GetPendingTime(EBufferedInput::Jump) == 41.0, TEXT("an older press replaced a newer one"));
+
+	// a full ring drops presses until it is drained
+	buffer.Reset();
+	for (uint32 i = 0; i < FMovementInputBuffer::Capacity; i++)
+		check(buffer.Push(EBufferedInput::Jump, 50.0 + i), TEXT("a press was dropped before the ring was full"));
+	check(!buffer.Push(EBufferedInput::Jump, 60.0), TEXT("a full ring accepted a press"));
+	buffer.Drain();
+	check(buffer.Push(EBufferedInput::Jump, 60.0), TEXT("a drained ring dropped a press"));
+
+	return failures;
+}
+
+int32 UMovementInputBufferCommandlet::CheckThreadedPushes()
+{
+	FMovementInputBuffer buffer;
+	std::atomic<bool> done(false);
+
+	// the producer retries until each press fits, the times only go up so the last one must be pending
+	TFuture<void> producer = Async(EAsyncExecution::Thread, [&buffer, &done, this]()
+	{
+		for (int32 i = 1; i <= Presses; i++)
+		{
+			while (!buffer.Push(i % 2 ? EBufferedInput::Jump : EBufferedInput::Grapple, i))
+				FPlatformProcess::Yield();
+		}
+		done = true;
+	});
+
+	while (!done)
+		buffer.Drain();
+	producer.Wait();
+	buffer.Drain();
+
+	const double lastJump = Presses % 2 ? Presses : Presses - 1;
+	const double lastGrapple = Presses % 2 ? Presses - 1 : Presses;
+	if (buffer.GetPendingTime(EBufferedInput::Jump) != lastJump || buffer.GetPendingTime(EBufferedInput::Grapple) != lastGrapple)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Input buffer: after %d threaded presses the pending times are %f and %f"), Presses,
+			buffer.GetPendingTime(EBufferedInput::Jump), buffer.GetPendingTime(EBufferedInput::Grapple));
+		return 1;
+	}
+	return 0;
+}
+
+int32 UMovementInputBufferCommandlet::CheckCharacter()
+{
+	UWorld* templateWorld = MovementSimulation::LoadTemplateWorld(MapName);
+	if (!templateWorld)
+		return 1;
+
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(Timestep);
+	UWorld* world = MovementSimulation::CreateWorld(templateWorld, 0);
+	AMovementMechanicsCharacter* character = MovementSimulation::SpawnScriptedCharacter(world, PawnClassName, MovementSimulation::FindSpawnTransform(world));
+
+	int32 failures = 1;
+	if (character)
+		failures = CheckBufferedJumps(world, character) + CheckBufferedGrapple(world, character);
+
+	MovementSimulation::DestroyWorld(world);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	return failures;
+}
+
+int32 UMovementInputBufferCommandlet::CheckBufferedJumps(UWorld* World, AMovementMechanicsCharacter* Character)
+{
+	UCharacterMovementComponent* movement = Character->GetCharacterMovement();
+	const float window = Character->GetJumpBufferTime();
+	const FCollisionShape capsule = Character->GetCapsuleComponent()->GetCollisionShape();
+	const FCollisionQueryParams params(SCENE_QUERY_STAT(InputBufferContact), false, Character);
+
+	int32 failures = 0;
+	int32 landingJumps = 0;
+	int32 wallJumps = 0;
+	// time stamp of the press waiting to fire, negative when there is none
+	double pressTime = -1.0;
+	bool buffered = false;
+
+	// run forward and turn so the character meets walls, every jump is pressed through the buffer
+	Character->SetScriptedAxes(1.0f, 0.0f);
+	const int32 frames = FMath::RoundToInt(Duration / Timestep);
+	for (int32 frame = 0; frame < frames; frame++)
+	{
+		const int32 jumpCount = Character->JumpCurrentCount;
+		const bool canJump = jumpCount < Character->JumpMaxCount;
+		const bool wallRunning = Character->IsWallRunning();
+		if (pressTime < 0.0)
+		{
+			// on the floor a plain press, in the air pressed when the sweep along the velocity finds the floor
+			// or a wall within half the window
+			FHitResult hit;
+			const FVector start = Character->GetActorLocation();
+			const FVector end = start + movement->Velocity * window * 0.5f;
+			const bool grounded = canJump && !movement->IsFalling();
+			buffered = !canJump && movement->IsFalling() && World->SweepSingleByChannel(hit, start, end, Character->GetActorQuat(), ECC_Pawn, capsule, params);
+			if (grounded || buffered)
+			{
+				pressTime = World->GetTimeSeconds();
+				Character->ScriptedJumpAt(pressTime);
+			}
+		}
+
+		if (AController* controller = Character->GetController())
+			controller->SetControlRotation(controller->GetControlRotation() + FRotator(0.0f, 30.0f * Timestep, 0.0f));
+		TickWorld(World);
+
+		if (pressTime < 0.0)
+			continue;
+
+		// the engine counts the jump on the frame the press acts
+		const bool fired = Character->JumpCurrentCount > jumpCount;
+		const double waited = World->GetTimeSeconds() - pressTime;
+		if (fired)
+		{
+			if (buffered && wallRunning)
+				wallJumps++;
+			else if (buffered)
+				landingJumps++;
+			pressTime = -1.0;
+		}
+		else if (canJump && waited <= window)
+		{
+			UE_LOG(LogMovementMechanics, Error, TEXT("Input buffer: a jump pressed %.3fs ago did not fire on the first frame the character could jump"), waited);
+			failures++;
+			pressTime = -1.0;
+		}
+		else if (waited > window)
+			pressTime = -1.0;
+	}
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("Input buffer: %d buffered jumps fired on landing, %d on a wall"), landingJumps, wallJumps);
+	if (landingJumps + wallJumps == 0)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Input buffer: no buffered jump was pressed before the character could jump"));
+		failures++;
+	}
+	return failures;
+}
+
+int32 UMovementInputBufferCommandlet::CheckBufferedGrapple(UWorld* World, AMovementMechanicsCharacter* Character)
+{
+	UGrapplingHookComponent* hook = Character->GrappleHookComponent;
+	if (!hook)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Input buffer: %s has no grapple"), *Character->GetName());
+		return 1;
+	}
+
+	// fire and detach once to start the cooldown
+	const int32 secondFrames = FMath::CeilToInt(1.0f / Timestep);
+	Character->SetScriptedAxes(0.0f, 0.0f);
+	Character->ScriptedGrapple();
+	for (int32 frame = 0; frame < secondFrames && !hook->IsInUse(); frame++)
+		TickWorld(World);
+	if (!hook->IsInUse())
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Input buffer: the grapple did not fire"));
+		return 1;
+	}
+	for (int32 frame = 0; frame < secondFrames / 4; frame++)
+		TickWorld(World);
+	// a hook that flew its whole range releases itself without a cooldown, detach starts it either way
+	hook->DetachGrapple();
+	TickWorld(World);
+
+	// pressed when the cooldown has half the window left
+	const float cooldown = Character->GetGrappleCooldown();
+	const float window = Character->GetGrappleBufferTime();
+	const int32 cooldownFrames = FMath::CeilToInt(cooldown / Timestep);
+	for (int32 frame = 0; frame < cooldownFrames && cooldown - hook->GetTimeSinceLastGrappleDetach() > window * 0.5f; frame++)
+		TickWorld(World);
+	if (hook->IsInUse() || hook->GetTimeSinceLastGrappleDetach() > cooldown)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Input buffer: the grapple is not cooling down"));
+		return 1;
+	}
+	Character->ScriptedGrappleAt(World->GetTimeSeconds());
+
+	const int32 windowFrames = FMath::CeilToInt(window / Timestep) + 1;
+	for (int32 frame = 0; frame < windowFrames; frame++)
+	{
+		TickWorld(World);
+		const bool cooledDown = hook->GetTimeSinceLastGrappleDetach() > cooldown;
+		if (hook->IsInUse() && !cooledDown)
+		{
+			UE_LOG(LogMovementMechanics, Error, TEXT("Input buffer: a buffered grapple fired during the cooldown"));
+			return 1;
+		}
+		if (cooledDown && !hook->IsInUse())
+		{
+			UE_LOG(LogMovementMechanics, Error, TEXT("Input buffer: a buffered grapple did not fire on the first frame after the cooldown"));
+			return 1;
+		}
+		if (hook->IsInUse())
+		{
+			UE_LOG(LogMovementMechanics, Display, TEXT("Input buffer: buffered grapple fired %.3fs after the cooldown"), hook->GetTimeSinceLastGrappleDetach() - cooldown);
+			return 0;
+		}
+	}
+
+	UE_LOG(LogMovementMechanics, Error, TEXT("Input buffer: a buffered grapple never fired"));
+	return 1;
+}
+
+void UMovementInputBufferCommandlet::TickWorld(UWorld* World)
+{
+	FApp::SetDeltaTime(Timestep);
+	World->Tick(LEVELTICK_All, Timestep);
+	GFrameCounter++;
+}
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementMechanicsMovementComponent.h"
+
+bool UMovementMechanicsMovementComponent::ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
+{
+	const bool error = Super::ServerCheckClientError(ClientTimeStamp, DeltaTime, Accel, ClientWorldLocation, RelativeClientLocation, ClientMovementBase, ClientBaseBoneName, ClientMovementMode);
+	if (error)
+		ServerCorrections++;
+	return error;
+}
+
+int32 UMovementMechanicsMovementComponent::ConsumeServerCorrections()
+{
+	const int32 corrections = ServerCorrections;
+	ServerCorrections = 0;
+	return corrections;
+}
+
+void UMovementMechanicsMovementComponent::SaveSnapshot(FMovementComponentSnapshot& Snapshot) const
+{
+	Snapshot.Velocity = Velocity;
+	Snapshot.PendingForce = PendingForceToApply;
+	Snapshot.PendingImpulse = PendingImpulseToApply;
+	Snapshot.PendingLaunchVelocity = PendingLaunchVelocity;
+	Snapshot.PlaneConstraintNormal = PlaneConstraintNormal;
+	Snapshot.GravityScale = GravityScale;
+	Snapshot.GroundFriction = GroundFriction;
+	Snapshot.AirControl = AirControl;
+	Snapshot.MaxWalkSpeed = MaxWalkSpeed;
+	Snapshot.MovementMode = MovementMode;
+	Snapshot.CustomMovementMode = CustomMovementMode;
+	Snapshot.bConstrainToPlane = bConstrainToPlane;
+}
+
+void UMovementMechanicsMovementComponent::RestoreSnapshot(const FMovementComponentSnapshot& Snapshot)
+{
+	// the mode first, changing it can touch the velocity
+	SetMovementMode((EMovementMode)Snapshot.MovementMode, Snapshot.CustomMovementMode);
+	Velocity = Snapshot.Velocity;
+	PendingForceToApply = Snapshot.PendingForce;
+	PendingImpulseToApply = Snapshot.PendingImpulse;
+	PendingLaunchVelocity = Snapshot.PendingLaunchVelocity;
+	PlaneConstraintNormal = Snapshot.PlaneConstraintNormal;
+	bConstrainToPlane = Snapshot.bConstrainToPlane;
+	GravityScale = Snapshot.GravityScale;
+	GroundFriction = Snapshot.GroundFriction;
+	AirControl = Snapshot.AirControl;
+	MaxWalkSpeed = Snapshot.MaxWalkSpeed;
+	// the floor is found again from the restored location
+	bForceNextFloorCheck = true;
+}
+
+void UMovementMechanicsMovementComponent::SetProxyState(const FMovementProxyState& State)
+{
+	ProxyState = State;
+	// the server changes the gravity during the wall run, the proxy falls the same way
+	GravityScale = State.GravityScale;
+
+	if (DefaultSmoothLocationTime < 0.0f)
+		DefaultSmoothLocationTime = NetworkSimulatedSmoothLocationTime;
+	const bool mechanics = bExtrapolateProxyMechanics && (State.bGrappling || State.bWallRunning);
+	NetworkSimulatedSmoothLocationTime = mechanics ? ProxyMechanicsSmoothLocationTime : DefaultSmoothLocationTime;
+}
+
+void UMovementMechanicsMovementComponent::SimulateMovement(float DeltaTime)
+{
+	if (bExtrapolateProxyMechanics && CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)
+		ExtrapolateProxyMechanics(DeltaTime);
+	Super::SimulateMovement(DeltaTime);
+}
+
+void UMovementMechanicsMovementComponent::ExtrapolateProxyMechanics(float DeltaTime)
+{
+	if (!UpdatedComponent || Mass <= 0.0f)
+		return;
+
+	if (ProxyState.bGrappling)
+	{
+		// the same pull the grapple component adds on the server
+		const FVector toAnchor = ((FVector)ProxyState.Anchor - UpdatedComponent->GetComponentLocation()).GetSafeNormal();
+		Velocity += toAnchor * (ProxyState.PullForce / Mass) * DeltaTime;
+	}
+	else if (ProxyState.bWallRunning)
+	{
+		// the server keeps the character on the wall, it never moves into or away from it
+		Velocity = FVector::VectorPlaneProject(Velocity, ProxyState.WallNormal);
+	}
+}
@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementMechanicsStats.h"
+
+DEFINE_LOG_CATEGORY(LogMovementMechanics);
+
+LLM_DEFINE_TAG(MovementWallRun);
+LLM_DEFINE_TAG(MovementGrapple);
+LLM_DEFINE_TAG(MovementSubsystems);
+
+DEFINE_STAT(STAT_MovementCharacterTick);
+DEFINE_STAT(STAT_MovementGrappleTick);
+DEFINE_STAT(STAT_MovementShootRayToWall);
+DEFINE_STAT(STAT_MovementUpdateWallRun);
+DEFINE_STAT(STAT_MovementStateWallRunning);
+DEFINE_STAT(STAT_MovementGrappleSpawn);
+DEFINE_STAT(STAT_MovementCharacterSpawn);
+DEFINE_STAT(STAT_MovementAnimTick);
+DEFINE_STAT(STAT_MovementInputLatencyFrames);
+DEFINE_STAT(STAT_MovementTimerWheel);
+DEFINE_STAT(STAT_MovementTimersScheduled);
+DEFINE_STAT(STAT_HitscanResolve);
+DEFINE_STAT(STAT_HitscanTracesPerFrame);
+DEFINE_STAT(STAT_PickUpProximity);
+DEFINE_STAT(STAT_PickUpsRegistered);
+DEFINE_STAT(STAT_PickUpProximityTests);
+DEFINE_STAT(STAT_PickUpHashMemory);
+DEFINE_STAT(STAT_GrappleRewindTrace);
+DEFINE_STAT(STAT_GrappleRewindMemory);
+
+bool FMovementTimings::bRecording = false;
+TArray<double> FMovementTimings::Samples[(int32)EMovementTimer::Count];
+TArray<double> FMovementTimings::InputLatencyFrames;
+
+const TCHAR* FMovementTimings::GetName(EMovementTimer Timer)
+{
+	switch (Timer)
+	{
+	case EMovementTimer::CharacterTick: return TEXT("Tick");
+	case EMovementTimer::GrappleTick: return TEXT("TickComponent");
+	case EMovementTimer::ShootRayToWall: return TEXT("ShootRayToWall");
+	case EMovementTimer::UpdateWallRun: return TEXT("UpdateWallRun");
+	case EMovementTimer::GrappleSpawn: return TEXT("FireGrapple");
+	case EMovementTimer::CharacterSpawn: return TEXT("CharacterSpawn");
+	case EMovementTimer::AnimTick: return TEXT("MeshTickComponent");
+	default: return TEXT("Unknown");
+	}
+}
+
+void FMovementTimings::Reset()
+{
+	for (TArray<double>& samples : Samples)
+		samples.Reset();
+	InputLatencyFrames.Reset();
+}
+
+#if !UE_BUILD_SHIPPING
+
+bool FMovementAllocationTracker::bEnabled = false;
+int32 FMovementAllocationTracker::Counts[(int32)EMovementTimer::Count] = {};
+EMovementTimer FMovementAllocationTracker::Scopes[FMovementAllocationTracker::MaxDepth] = {};
+int32 FMovementAllocationTracker::Depth = 0;
+
+// forwards everything to the real allocator and counts the allocations made inside a movement scope
+class FMovementCountingMalloc final : public FMalloc
+{
+public:
+	FMovementCountingMalloc(FMalloc* InInner)
+		: Inner(InInner)
+	{
+	}
+
+	virtual void* Malloc(SIZE_T Size, uint32 Alignment) override
+	{
+		FMovementAllocationTracker::CountAllocation();
+		return Inner->Malloc(Size, Alignment);
+	}
+
+	virtual void* TryMalloc(SIZE_T Size, uint32 Alignment) override
+	{
+		FMovementAllocationTracker::CountAllocation();
+		return Inner->TryMalloc(Size, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Size, uint32 Alignment) override
+	{
+		FMovementAllocationTracker::CountAllocation();
+		return Inner->Realloc(Original, Size, Alignment);
+	}
+
+	virtual void* TryRealloc(void* Original, SIZE_T Size, uint32 Alignment) override
+	{
+		FMovementAllocationTracker::CountAllocation();
+		return Inner->TryRealloc(Original, Size, Alignment);
+	}
+
+	virtual void Free(void* Original) override { Inner->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+	virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+	virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+	virtual void UpdateStats() override { Inner->UpdateStats(); }
+	virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+	virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+	virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+	virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+	virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+private:
+	FMalloc* Inner;
+};
+
+static bool GMovementCountingMallocInstalled = false;
+
+void FMovementAllocationTracker::Install()
+{
+	if (GMovementCountingMallocInstalled)
+		return;
+
+	// everything allocated before is freed through the same inner allocator, so it is safe to wrap late
+	GMalloc = new FMovementCountingMalloc(GMalloc);
+	GMovementCountingMallocInstalled = true;
+}
+
+bool FMovementAllocationTracker::IsInstalled()
+{
+	return GMovementCountingMallocInstalled;
+}
+
+void FMovementAllocationTracker::Reset()
+{
+	for (int32& count : Counts)
+		count = 0;
+}
+
+void FMovementAllocationTracker::CountAllocation()
+{
+	if (!bEnabled || Depth <= 0 || !IsInGameThread())
+		return;
+
+	for (int32 i = 0; i < FMath::Min(Depth, MaxDepth); i++)
+		Counts[(int32)Scopes[i]]++;
+}
+
+#endif
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementNavLinkComponent.h"
+#include "MovementMechanicsCharacter.h"
+#include "GameFramework/Controller.h"
+
+UNavArea_WallRun::UNavArea_WallRun()
+{
+	DefaultCost = 2.0f;
+	DrawColor = FColor(255, 160, 0);
+}
+
+UNavArea_Grapple::UNavArea_Grapple()
+{
+	DefaultCost = 3.0f;
+	DrawColor = FColor(0, 200, 255);
+}
+
+bool UMovementNavLinkComponent::OnLinkMoveStarted(UObject* PathComp, const FVector& DestPoint)
+{
+	// the path following component belongs to the controller of the bot
+	UActorComponent* pathFollowing = Cast<UActorComponent>(PathComp);
+	AController* controller = pathFollowing ? Cast<AController>(pathFollowing->GetOwner()) : nullptr;
+	if (AMovementMechanicsCharacter* character = controller ? Cast<AMovementMechanicsCharacter>(controller->GetPawn()) : nullptr)
+		character->StartNavLinkTraversal(Traversal, Anchor);
+
+	// no custom move, the path following moves to the end of the link as usual
+	return false;
+}
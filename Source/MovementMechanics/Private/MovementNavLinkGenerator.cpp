@@ -0,0 +1,265 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementNavLinkGenerator.h"
+#include "MovementMechanicsStats.h"
+#include "MovementNavLinkComponent.h"
+#include "MovementMechanicsCharacter.h"
+#include "MovementMechanicsCollision.h"
+#include "GrapplingHookComponent.h"
+#include "Grapple.h"
+#include "Async/ParallelFor.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+
+const FName AMovementNavLinkGenerator::LinkTag(TEXT("MovementNavLink"));
+
+namespace MovementNavLinks
+{
+	// movement rules read once from the character defaults, shared by the tile tasks
+	struct FRules
+	{
+		float CapsuleRadius;
+		float CapsuleHalfHeight;
+		float WalkableFloorAngle;
+		float WallHeight;
+		float WallTraceLength;
+		float WalkingSpeed;
+		float WallRunGravity;
+		float JumpHeight;
+		float GrappleRange;
+		float GrappleSpeed;
+		float PullSpeed;
+		float DisconnectDistance;
+	};
+
+	struct FLink
+	{
+		EMovementTraversal Traversal;
+		FVector Start;
+		FVector End;
+		FVector Anchor;
+		float Cost;
+		NavNodeRef EndPoly;
+	};
+}
+
+AMovementNavLinkGenerator::AMovementNavLinkGenerator()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	CharacterClass = AMovementMechanicsCharacter::StaticClass();
+}
+
+void AMovementNavLinkGenerator::GenerateLinks()
+{
+#if WITH_EDITOR && WITH_RECAST
+	using namespace MovementNavLinks;
+
+	UNavigationSystemV1* navigation = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	ARecastNavMesh* navMesh = navigation ? Cast<ARecastNavMesh>(navigation->GetDefaultNavDataInstance()) : nullptr;
+	const AMovementMechanicsCharacter* character = CharacterClass ? CharacterClass->GetDefaultObject<AMovementMechanicsCharacter>() : nullptr;
+	if (!navMesh || !character)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Nav link generation needs a navmesh and a character class"));
+		return;
+	}
+
+	RemoveLinks();
+
+	const UCharacterMovementComponent* movement = character->GetCharacterMovement();
+	const float gravity = FMath::Abs(GetWorld()->GetGravityZ());
+	FRules rules;
+	rules.CapsuleRadius = character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	rules.CapsuleHalfHeight = character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	rules.WalkableFloorAngle = movement->GetWalkableFloorAngle();
+	rules.WallHeight = character->WallHeight;
+	rules.WallTraceLength = character->WallTraceLength;
+	rules.WalkingSpeed = character->WalkingSpeed;
+	rules.WallRunGravity = gravity * character->GravityScale;
+	rules.JumpHeight = FMath::Square(movement->JumpZVelocity) / (2.0f * gravity);
+	const UGrapplingHookComponent* grapple = character->GrappleHookComponent;
+	const AGrapple* hook = grapple && grapple->HookClass ? grapple->HookClass->GetDefaultObject<AGrapple>() : nullptr;
+	rules.GrappleRange = hook ? hook->MaxDistance : 0.0f;
+	rules.GrappleSpeed = grapple ? grapple->GrappleSpeed : 1.0f;
+	rules.PullSpeed = grapple ? grapple->PullInitialSpeed : 1.0f;
+	rules.DisconnectDistance = grapple ? grapple->DisconnectDistance : 0.0f;
+
+	UWorld* world = GetWorld();
+	const FVector landingExtent(rules.CapsuleRadius * 2.0f, rules.CapsuleRadius * 2.0f, LandingSearchHeight);
+	const FCollisionQueryParams traceParams(SCENE_QUERY_STAT(NavLinkTrace), false);
+
+	// finds the navmesh below the end of a traversal
+	auto findLanding = [&](const FVector& Point, const FVector& Extent, FNavLocation& Landing)
+	{
+		return navMesh->ProjectPoint(Point - FVector(0.0f, 0.0f, Extent.Z * 0.5f), Landing, Extent);
+	};
+
+	// follows a wall from where the jump reaches it until it ends, a wall run link is added when it leads to another polygon
+	auto scanWallRun = [&](const FNavPoly& Poly, const FVector& Direction, TArray<FLink>& Links)
+	{
+		const FVector jumpApex = Poly.Center + FVector(0.0f, 0.0f, rules.CapsuleHalfHeight + rules.JumpHeight);
+		// same height rule as OnCompHit
+		if (jumpApex.Z <= rules.WallHeight)
+			return;
+
+		FHitResult wallHit;
+		if (!world->LineTraceSingleByChannel(wallHit, jumpApex, jumpApex + Direction * WallSearchDistance, ECC_WallRun, traceParams))
+			return;
+		if (!AMovementMechanicsCharacter::IsWallRunnableSurface(wallHit.ImpactNormal, rules.WalkableFloorAngle))
+			return;
+
+		const FVector wallNormal = FVector(wallHit.ImpactNormal.X, wallHit.ImpactNormal.Y, 0.0f).GetSafeNormal();
+		// the side depends on how the bot approaches, try both run directions
+		for (float side : { 1.0f, -1.0f })
+		{
+			const FVector runDirection = FVector::CrossProduct(wallNormal, FVector(0.0f, 0.0f, side));
+			FVector position = wallHit.ImpactPoint + wallNormal * rules.CapsuleRadius;
+			float length = 0.0f;
+			while (length < MaxWallRunLength)
+			{
+				// gravity is scaled down while running
+				const float time = (length + WallRunStep) / rules.WalkingSpeed;
+				FVector next = position + runDirection * WallRunStep;
+				next.Z = jumpApex.Z - 0.5f * rules.WallRunGravity * time * time;
+				if (next.Z <= Poly.Center.Z)
+					break;
+
+				FHitResult hit;
+				if (world->LineTraceSingleByChannel(hit, position, next, ECC_WallRun, traceParams))
+					break;
+				// same reach as ShootRayToWall
+				if (!world->LineTraceSingleByChannel(hit, next, next - wallNormal * rules.WallTraceLength, ECC_WallRun, traceParams)
+					|| !AMovementMechanicsCharacter::IsWallRunnableSurface(hit.ImpactNormal, rules.WalkableFloorAngle))
+					break;
+
+				position = next;
+				length += WallRunStep;
+			}
+
+			if (length < MinLinkLength)
+				continue;
+
+			FNavLocation landing;
+			if (!findLanding(position + runDirection * rules.CapsuleRadius * 2.0f + wallNormal * rules.CapsuleRadius, landingExtent, landing))
+				continue;
+
+			Links.Add({ EMovementTraversal::WallRun, Poly.Center, landing.Location, FVector::ZeroVector, length / rules.WalkingSpeed, landing.NodeRef });
+		}
+	};
+
+	// aims at anything the hook can attach to, a grapple link is added when the pull ends over another polygon
+	auto scanGrapple = [&](const FNavPoly& Poly, const FVector& Direction, TArray<FLink>& Links)
+	{
+		const FVector eye = Poly.Center + FVector(0.0f, 0.0f, rules.CapsuleHalfHeight * 2.0f * 0.8f);
+		FHitResult hit;
+		if (!world->LineTraceSingleByChannel(hit, eye, eye + Direction * rules.GrappleRange, ECC_Grapple, traceParams))
+			return;
+
+		// the pull lets go DisconnectDistance away from the hook
+		const FVector landingExtentGrapple(FMath::Max(rules.DisconnectDistance, rules.CapsuleRadius), FMath::Max(rules.DisconnectDistance, rules.CapsuleRadius), LandingSearchHeight);
+		FNavLocation landing;
+		if (!findLanding(hit.ImpactPoint + hit.ImpactNormal * rules.CapsuleRadius * 2.0f, landingExtentGrapple, landing))
+			return;
+		if (FVector::Dist(landing.Location, Poly.Center) < MinLinkLength)
+			return;
+
+		const float cost = hit.Distance / rules.GrappleSpeed + FVector::Dist(eye, hit.ImpactPoint) / rules.PullSpeed;
+		Links.Add({ EMovementTraversal::Grapple, Poly.Center, landing.Location, hit.ImpactPoint, cost, landing.NodeRef });
+	};
+
+	// every tile is scanned on its own, the traces and navmesh projections are read only
+	const int32 tileCount = navMesh->GetNavMeshTilesCount();
+	TArray<TArray<FLink>> tileLinks;
+	tileLinks.SetNum(tileCount);
+	ParallelFor(tileCount, [&](int32 TileIndex)
+	{
+		TArray<FNavPoly> polys;
+		if (!navMesh->GetPolysInTile(TileIndex, polys))
+			return;
+
+		TArray<FLink> polyLinks;
+		for (const FNavPoly& poly : polys)
+		{
+			polyLinks.Reset();
+			for (int32 i = 0; i < SearchDirections; i++)
+			{
+				const float yaw = 360.0f * i / SearchDirections;
+				if (bWallRunLinks)
+					scanWallRun(poly, FRotator(0.0f, yaw, 0.0f).Vector(), polyLinks);
+				if (bGrappleLinks && rules.GrappleRange > 0.0f)
+				{
+					for (float pitch : GrapplePitches)
+						scanGrapple(poly, FRotator(pitch, yaw, 0.0f).Vector(), polyLinks);
+				}
+			}
+
+			// cheapest link to each landing polygon, a few per polygon
+			polyLinks.RemoveAll([&poly](const FLink& link) { return link.EndPoly == poly.Ref; });
+			polyLinks.Sort([](const FLink& a, const FLink& b) { return a.Cost < b.Cost; });
+			TSet<NavNodeRef> landings;
+			int32 kept = 0;
+			for (const FLink& link : polyLinks)
+			{
+				if (kept >= MaxLinksPerPolygon)
+					break;
+				bool alreadyLinked;
+				landings.Add(link.EndPoly, &alreadyLinked);
+				if (alreadyLinked)
+					continue;
+				tileLinks[TileIndex].Add(link);
+				kept++;
+			}
+		}
+	});
+
+	// components can only be created on the game thread
+	Modify();
+	int32 generated = 0;
+	const FTransform& transform = GetActorTransform();
+	for (const TArray<FLink>& links : tileLinks)
+	{
+		for (const FLink& link : links)
+		{
+			UMovementNavLinkComponent* component = NewObject<UMovementNavLinkComponent>(this, NAME_None, RF_Transactional);
+			component->ComponentTags.Add(LinkTag);
+			component->Traversal = link.Traversal;
+			component->Cost = link.Cost;
+			component->Anchor = link.Anchor;
+			component->SetLinkData(transform.InverseTransformPosition(link.Start), transform.InverseTransformPosition(link.End), ENavLinkDirection::LeftToRight);
+			if (link.Traversal == EMovementTraversal::WallRun)
+				component->SetEnabledArea(UNavArea_WallRun::StaticClass());
+			else
+				component->SetEnabledArea(UNavArea_Grapple::StaticClass());
+			AddInstanceComponent(component);
+			component->RegisterComponent();
+			generated++;
+		}
+	}
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("Generated %d movement nav links over %d tiles"), generated, tileCount);
+#endif
+}
+
+void AMovementNavLinkGenerator::RemoveLinks()
+{
+#if WITH_EDITOR
+	int32 removed = 0;
+	TArray<UMovementNavLinkComponent*> links;
+	GetComponents(links);
+	for (UMovementNavLinkComponent* link : links)
+	{
+		if (!link->ComponentHasTag(LinkTag))
+			continue;
+
+		Modify();
+		RemoveInstanceComponent(link);
+		link->DestroyComponent();
+		removed++;
+	}
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("Removed %d movement nav links"), removed);
+#endif
+}
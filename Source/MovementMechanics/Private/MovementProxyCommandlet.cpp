@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementProxyCommandlet.h"
+#include "MovementMechanicsStats.h"
+#include "MovementBenchmarkCommandlet.h"
+#include "MovementSimulation.h"
+#include "MovementMechanicsCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonSerializer.h"
+
+UMovementProxyCommandlet::UMovementProxyCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UMovementProxyCommandlet::Main(const FString& Params)
+{
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Pawn="), PawnClassName);
+	FParse::Value(*Params, TEXT("Timestep="), Timestep);
+	FParse::Value(*Params, TEXT("LatencyMs="), LatencyMs);
+	FParse::Value(*Params, TEXT("Duration="), Duration);
+
+	FString ratesString;
+	if (FParse::Value(*Params, TEXT("Rates="), ratesString, false))
+	{
+		TArray<FString> rates;
+		ratesString.ParseIntoArray(rates, TEXT(","));
+		UpdateRates.Reset();
+		for (const FString& rate : rates)
+			UpdateRates.Add(FCString::Atof(*rate));
+	}
+
+	UWorld* templateWorld = MovementSimulation::LoadTemplateWorld(MapName);
+	if (!templateWorld)
+		return 1;
+
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(Timestep);
+
+	TArray<TSharedPtr<FJsonValue>> cases;
+	int32 worldIndex = 0;
+	for (float rate : UpdateRates)
+	{
+		TSharedPtr<FJsonObject> engine = RunCase(templateWorld, rate, false, worldIndex++);
+		TSharedPtr<FJsonObject> mechanics = RunCase(templateWorld, rate, true, worldIndex++);
+		if (!engine || !mechanics)
+			return 1;
+
+		UE_LOG(LogMovementMechanics, Display, TEXT("%.0f updates/s: engine %.1fcm mean %.1fcm p99, mechanics %.1fcm mean %.1fcm p99"), rate,
+			engine->GetNumberField(TEXT("Mean")), engine->GetNumberField(TEXT("P99")),
+			mechanics->GetNumberField(TEXT("Mean")), mechanics->GetNumberField(TEXT("P99")));
+		cases.Add(MakeShared<FJsonValueObject>(engine));
+		cases.Add(MakeShared<FJsonValueObject>(mechanics));
+	}
+
+	FString outputPath;
+	if (FParse::Value(*Params, TEXT("Output="), outputPath))
+	{
+		TSharedPtr<FJsonObject> results = MakeShared<FJsonObject>();
+		results->SetNumberField(TEXT("Timestep"), Timestep);
+		results->SetNumberField(TEXT("LatencyMs"), LatencyMs);
+		results->SetArrayField(TEXT("Cases"), cases);
+
+		FString json;
+		TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+		FJsonSerializer::Serialize(results.ToSharedRef(), writer);
+		if (!FFileHelper::SaveStringToFile(json, *outputPath))
+		{
+			UE_LOG(LogMovementMechanics, Error, TEXT("Could not write %s"), *outputPath);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+TSharedPtr<FJsonObject> UMovementProxyCommandlet::RunCase(UWorld* TemplateWorld, float UpdateRate, bool bExtrapolate, int32 WorldIndex)
+{
+	UWorld* world = MovementSimulation::CreateWorld(TemplateWorld, WorldIndex);
+	const FTransform spawnTransform = MovementSimulation::FindSpawnTransform(world);
+	AMovementMechanicsCharacter* server = MovementSimulation::SpawnScriptedCharacter(world, PawnClassName, spawnTransform);
+	AMovementMechanicsCharacter* proxy = MovementSimulation::SpawnCharacter(world, PawnClassName, spawnTransform);
+	if (!server || !proxy)
+	{
+		MovementSimulation::DestroyWorld(world);
+		return nullptr;
+	}
+
+	// both start on the same spot and must not push each other
+	server->GetCapsuleComponent()->IgnoreActorWhenMoving(proxy, true);
+	proxy->GetCapsuleComponent()->IgnoreActorWhenMoving(server, true);
+	proxy->SetRole(ROLE_SimulatedProxy);
+	if (UMovementMechanicsMovementComponent* movement = Cast<UMovementMechanicsMovementComponent>(proxy->GetCharacterMovement()))
+		movement->bExtrapolateProxyMechanics = bExtrapolate;
+
+	const int32 frames = FMath::CeilToInt(Duration / Timestep);
+	const float updateInterval = 1.0f / FMath::Max(UpdateRate, 1.0f);
+	const float latency = LatencyMs / 1000.0f;
+	TArray<FProxyUpdate> inFlight;
+	TArray<double> errors;
+	errors.Reserve(frames);
+	float time = 0.0f;
+	float nextUpdateTime = 0.0f;
+	bool received = false;
+	for (int32 frame = 0; frame < frames; frame++)
+	{
+		DriveCharacter(server, frame);
+		FApp::SetDeltaTime(Timestep);
+		world->Tick(LEVELTICK_All, Timestep);
+		GFrameCounter++;
+		time += Timestep;
+
+		// what the server would send this frame
+		if (time >= nextUpdateTime)
+		{
+			server->GatherCurrentMovement();
+			FProxyUpdate& update = inFlight.AddDefaulted_GetRef();
+			update.DeliveryTime = time + latency;
+			update.Movement = server->GetReplicatedMovement();
+			update.MovementMode = server->GetCharacterMovement()->PackNetworkMovementMode();
+			update.State = server->GetProxyState();
+			nextUpdateTime += updateInterval;
+		}
+		while (inFlight.Num() > 0 && inFlight[0].DeliveryTime <= time)
+		{
+			DeliverUpdate(proxy, inFlight[0]);
+			inFlight.RemoveAt(0, 1, false);
+			received = true;
+		}
+
+		// the proxy moves in the next frame's tick, compare once it has something to extrapolate from
+		if (received)
+			errors.Add(FVector::Distance(proxy->GetActorLocation(), server->GetActorLocation()));
+	}
+
+	TSharedPtr<FJsonObject> result = UMovementBenchmarkCommandlet::MakeTimerResult(errors);
+	result->SetNumberField(TEXT("UpdateRate"), UpdateRate);
+	result->SetBoolField(TEXT("ExtrapolateMechanics"), bExtrapolate);
+
+	MovementSimulation::DestroyWorld(world);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	return result;
+}
+
+void UMovementProxyCommandlet::DeliverUpdate(AMovementMechanicsCharacter* Proxy, const FProxyUpdate& Update)
+{
+	// the order a client applies a bunch in: properties, their notifies, then PostNetReceive
+	Proxy->ReplicatedMovementMode = Update.MovementMode;
+	Proxy->SetReplicatedMovement(Update.Movement);
+	Proxy->SetProxyState(Update.State);
+	Proxy->OnRep_ReplicatedMovement();
+	Proxy->PostNetReceive();
+}
+
+void UMovementProxyCommandlet::DriveCharacter(AMovementMechanicsCharacter* Character, int32 Frame)
+{
+	Character->SetScriptedAxes(1.0f, 0.0f);
+	if (Frame % 60 == 0)
+		Character->ScriptedJump();
+	if (Frame % 180 == 90)
+		Character->ScriptedGrapple();
+	if (AController* controller = Character->GetController())
+		controller->SetControlRotation(controller->GetControlRotation() + FRotator(0.0f, 0.5f, 0.0f));
+}
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementRollbackCommandlet.h"
+#include "MovementMechanicsStats.h"
+#include "MovementSimulation.h"
+#include "MovementMechanicsCharacter.h"
+#include "MovementSnapshot.h"
+#include "Engine/World.h"
+#include "Misc/App.h"
+
+UMovementRollbackCommandlet::UMovementRollbackCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UMovementRollbackCommandlet::Main(const FString& Params)
+{
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Pawn="), PawnClassName);
+	FParse::Value(*Params, TEXT("Timestep="), Timestep);
+	FParse::Value(*Params, TEXT("Checks="), Checks);
+	FParse::Value(*Params, TEXT("Spacing="), Spacing);
+	FParse::Value(*Params, TEXT("Frames="), Frames);
+
+	UWorld* templateWorld = MovementSimulation::LoadTemplateWorld(MapName);
+	if (!templateWorld)
+		return 1;
+
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(Timestep);
+
+	UWorld* world = MovementSimulation::CreateWorld(templateWorld, 0);
+	AMovementMechanicsCharacter* character = MovementSimulation::SpawnScriptedCharacter(world, PawnClassName, MovementSimulation::FindSpawnTransform(world));
+	if (!character)
+	{
+		MovementSimulation::DestroyWorld(world);
+		return 1;
+	}
+
+	int32 failures = 0;
+	int32 frame = 0;
+	TArray<FVector> unused;
+	TArray<FVector> first;
+	TArray<FVector> second;
+	for (int32 check = 0; check < Checks; check++)
+	{
+		RunFrames(world, character, frame, Spacing, unused);
+		frame += Spacing;
+
+		FMovementSnapshot snapshot;
+		character->SaveSnapshot(snapshot);
+		RunFrames(world, character, frame, Frames, first);
+		character->RestoreSnapshot(snapshot);
+		RunFrames(world, character, frame, Frames, second);
+
+		// bit identical, not nearly equal
+		for (int32 i = 0; i < first.Num(); i++)
+		{
+			if (FMemory::Memcmp(&first[i], &second[i], sizeof(FVector)) != 0)
+			{
+				UE_LOG(LogMovementMechanics, Error, TEXT("Check %d at frame %d: trajectories differ %d frames after the restore, %s != %s"),
+					check, frame, i / 2, *first[i].ToString(), *second[i].ToString());
+				failures++;
+				break;
+			}
+		}
+
+		// carry on from the end of the rerun
+		frame += Frames;
+	}
+
+	MovementSimulation::DestroyWorld(world);
+
+	if (failures > 0)
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("MovementRollback: %d of %d checks failed"), failures, Checks);
+		return 1;
+	}
+	UE_LOG(LogMovementMechanics, Display, TEXT("MovementRollback: %d checks passed"), Checks);
+	return 0;
+}
+
+void UMovementRollbackCommandlet::RunFrames(UWorld* World, AMovementMechanicsCharacter* Character, int32 Frame, int32 Count, TArray<FVector>& OutTrajectory)
+{
+	OutTrajectory.Reset();
+	for (int32 i = 0; i < Count; i++)
+	{
+		DriveCharacter(Character, Frame + i);
+		FApp::SetDeltaTime(Timestep);
+		World->Tick(LEVELTICK_All, Timestep);
+		GFrameCounter++;
+
+		OutTrajectory.Add(Character->GetActorLocation());
+		OutTrajectory.Add(Character->GetVelocity());
+	}
+}
+
+void UMovementRollbackCommandlet::DriveCharacter(AMovementMechanicsCharacter* Character, int32 Frame)
+{
+	// same loop as the benchmark: run forward, jump every second, grapple every three seconds
+	Character->SetScriptedAxes(1.0f, 0.0f);
+	if (Frame % 60 == 0)
+		Character->ScriptedJump();
+	if (Frame % 180 == 90)
+		Character->ScriptedGrapple();
+	if (AController* controller = Character->GetController())
+		controller->SetControlRotation(controller->GetControlRotation() + FRotator(0.0f, 0.5f, 0.0f));
+}
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementSimulation.h"
+#include "MovementMechanicsCharacter.h"
+#include "MovementMechanicsStats.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerStart.h"
+#include "UObject/Package.h"
+
+UWorld* MovementSimulation::LoadTemplateWorld(const FString& MapName)
+{
+	UPackage* mapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* world = mapPackage ? UWorld::FindWorldInPackage(mapPackage) : nullptr;
+	if (!world)
+		UE_LOG(LogMovementMechanics, Error, TEXT("Could not load map %s"), *MapName);
+	return world;
+}
+
+UWorld* MovementSimulation::CreateWorld(UWorld* TemplateWorld, int32 Index)
+{
+	// each simulation gets its own copy of the map so the worlds don't interact
+	UPackage* package = CreatePackage(*FString::Printf(TEXT("/Temp/MovementSimulation/World_%d"), Index));
+	FObjectDuplicationParameters duplicationParams(TemplateWorld, package);
+	duplicationParams.DestName = TemplateWorld->GetFName();
+	duplicationParams.DuplicateMode = EDuplicateMode::World;
+	UWorld* world = CastChecked<UWorld>(StaticDuplicateObjectEx(duplicationParams));
+	world->WorldType = EWorldType::Game;
+	world->AddToRoot();
+
+	FWorldContext& context = GEngine->CreateNewWorldContext(EWorldType::Game);
+	context.SetCurrentWorld(world);
+
+	world->InitWorld(UWorld::InitializationValues()
+		.AllowAudioPlayback(false)
+		.RequiresHitProxies(false)
+		.CreateNavigation(false)
+		.CreateAISystem(true)
+		.CreatePhysicsScene(true)
+		.ShouldSimulatePhysics(true));
+
+	FURL url;
+	world->SetGameMode(url);
+	world->InitializeActorsForPlay(url);
+	world->BeginPlay();
+	return world;
+}
+
+void MovementSimulation::DestroyWorld(UWorld* World)
+{
+	World->DestroyWorld(false);
+	GEngine->DestroyWorldContext(World);
+	World->RemoveFromRoot();
+}
+
+FTransform MovementSimulation::FindSpawnTransform(UWorld* World)
+{
+	for (TActorIterator<APlayerStart> it(World); it; ++it)
+		return it->GetActorTransform();
+	return FTransform::Identity;
+}
+
+AMovementMechanicsCharacter* MovementSimulation::SpawnCharacter(UWorld* World, const FString& PawnClassName, const FTransform& SpawnTransform)
+{
+	UClass* pawnClass = LoadClass<AMovementMechanicsCharacter>(nullptr, *PawnClassName);
+	if (!pawnClass)
+		pawnClass = AMovementMechanicsCharacter::StaticClass();
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	AMovementMechanicsCharacter* character = World->SpawnActor<AMovementMechanicsCharacter>(pawnClass, SpawnTransform, spawnParams);
+	if (!character)
+		UE_LOG(LogMovementMechanics, Error, TEXT("Could not spawn %s"), *PawnClassName);
+	return character;
+}
+
+AMovementMechanicsCharacter* MovementSimulation::SpawnScriptedCharacter(UWorld* World, const FString& PawnClassName, const FTransform& SpawnTransform)
+{
+	MOVEMENT_SCOPE_TIMER(STAT_MovementCharacterSpawn, EMovementTimer::CharacterSpawn);
+
+	AMovementMechanicsCharacter* character = SpawnCharacter(World, PawnClassName, SpawnTransform);
+	if (!character)
+		return nullptr;
+
+	// ai controller so the movement component consumes the scripted input
+	character->SpawnDefaultController();
+	return character;
+}
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementSoakCommandlet.h"
+#include "MovementMechanicsStats.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+
+UMovementSoakCommandlet::UMovementSoakCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UMovementSoakCommandlet::Main(const FString& Params)
+{
+	FString outputPath;
+	if (!FParse::Value(*Params, TEXT("Output="), outputPath))
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("MovementSoak needs -Output="));
+		return 1;
+	}
+	outputPath = FPaths::ConvertRelativePathToFull(outputPath);
+
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Clients="), ClientCount);
+	FParse::Value(*Params, TEXT("Duration="), Duration);
+	FParse::Value(*Params, TEXT("Interval="), Interval);
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("PktLag="), PktLag);
+	FParse::Value(*Params, TEXT("PktLagVariance="), PktLagVariance);
+	FParse::Value(*Params, TEXT("PktLoss="), PktLoss);
+	FParse::Value(*Params, TEXT("Timeout="), Timeout);
+
+	const FString packetEmulation = FString::Printf(TEXT("PktLag=%d PktLagVariance=%d PktLoss=%d"), PktLag, PktLagVariance, PktLoss);
+	const FString soakArguments = FString::Printf(TEXT("-SoakDuration=%f -SoakInterval=%f"), Duration, Interval);
+
+	FProcHandle server = Launch(FString::Printf(TEXT("%s -server -port=%d -MovementSoak=Server -SoakOutput=\"%s\" %s %s"),
+		*MapName, Port, *outputPath, *soakArguments, *packetEmulation), TEXT("SoakServer.log"));
+	if (!server.IsValid())
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Could not start the soak server"));
+		return 1;
+	}
+
+	// let the server load the map before the clients connect
+	FPlatformProcess::Sleep(10.0f);
+
+	TArray<FProcHandle> clients;
+	for (int32 i = 0; i < ClientCount; i++)
+	{
+		clients.Add(Launch(FString::Printf(TEXT("127.0.0.1:%d -game -nosound -MovementSoak=Client -SoakIndex=%d %s %s"),
+			Port, i, *soakArguments, *packetEmulation), FString::Printf(TEXT("SoakClient%d.log"), i)));
+	}
+
+	const double startTime = FPlatformTime::Seconds();
+	while (FPlatformProcess::IsProcRunning(server) && FPlatformTime::Seconds() - startTime < Duration + Timeout)
+		FPlatformProcess::Sleep(1.0f);
+
+	int32 result = 1;
+	if (FPlatformProcess::IsProcRunning(server))
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Soak server did not finish in time"));
+		FPlatformProcess::TerminateProc(server, true);
+	}
+	else if (!FPlatformProcess::GetProcReturnCode(server, &result))
+	{
+		result = 1;
+	}
+	FPlatformProcess::CloseProc(server);
+
+	for (FProcHandle& client : clients)
+	{
+		if (FPlatformProcess::IsProcRunning(client))
+			FPlatformProcess::TerminateProc(client, true);
+		FPlatformProcess::CloseProc(client);
+	}
+
+	if (result == 0)
+		UE_LOG(LogMovementMechanics, Display, TEXT("MovementSoak finished, results in %s"), *outputPath);
+	return result;
+}
+
+FProcHandle UMovementSoakCommandlet::Launch(const FString& Arguments, const FString& LogName)
+{
+	// the same executable, headless and without any prompts
+	const FString commandLine = FString::Printf(TEXT("\"%s\" %s -nullrhi -unattended -nosplash -log=%s"),
+		*FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()), *Arguments, *LogName);
+	UE_LOG(LogMovementMechanics, Display, TEXT("Starting %s"), *commandLine);
+	return FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *commandLine, false, true, true, nullptr, 0, nullptr, nullptr);
+}
@@ -0,0 +1,177 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementSoakSubsystem.h"
+#include "GrappleRewindSubsystem.h"
+#include "MovementMechanicsCharacter.h"
+#include "MovementMechanicsMovementComponent.h"
+#include "MovementMechanicsStats.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+
+bool UMovementSoakSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	FString role;
+	return FParse::Value(FCommandLine::Get(), TEXT("MovementSoak="), role) && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UMovementSoakSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FString role;
+	FParse::Value(FCommandLine::Get(), TEXT("MovementSoak="), role);
+	bServer = role == TEXT("Server");
+	FParse::Value(FCommandLine::Get(), TEXT("SoakDuration="), Duration);
+	FParse::Value(FCommandLine::Get(), TEXT("SoakInterval="), SampleInterval);
+	FParse::Value(FCommandLine::Get(), TEXT("SoakIndex="), ClientIndex);
+	FParse::Value(FCommandLine::Get(), TEXT("SoakOutput="), OutputPath);
+}
+
+void UMovementSoakSubsystem::Tick(float DeltaTime)
+{
+	LLM_SCOPE_BYTAG(MovementSubsystems);
+	if (!GetWorld()->IsGameWorld())
+		return;
+
+	if (bServer)
+		TickServer(DeltaTime);
+	else
+		TickClient(DeltaTime);
+}
+
+TStatId UMovementSoakSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMovementSoakSubsystem, STATGROUP_Tickables);
+}
+
+void UMovementSoakSubsystem::TickClient(float DeltaTime)
+{
+	if (!Character.IsValid())
+	{
+		APlayerController* controller = GetWorld()->GetFirstPlayerController();
+		AMovementMechanicsCharacter* character = controller ? Cast<AMovementMechanicsCharacter>(controller->GetPawn()) : nullptr;
+		if (!character)
+			return;
+
+		// drive the character from the scripted axes instead of the input component
+		character->ForceMovementPolicy(EMovementPolicy::Bot);
+		Character = character;
+		SoakTime = 0.0f;
+	}
+
+	// the same loop as the benchmark, offset per client so they don't all jump on the same frame
+	const float offset = ClientIndex * 0.13f;
+	const float previousTime = SoakTime + offset;
+	SoakTime += DeltaTime;
+	const float time = SoakTime + offset;
+
+	Character->SetScriptedAxes(1.0f, 0.0f);
+	if (FMath::FloorToInt(time) != FMath::FloorToInt(previousTime))
+		Character->ScriptedJump();
+	if (FMath::FloorToInt(time / 3.0f) != FMath::FloorToInt(previousTime / 3.0f))
+		Character->ScriptedGrapple();
+	if (AController* controller = Character->GetController())
+		controller->SetControlRotation(controller->GetControlRotation() + FRotator(0.0f, 30.0f * DeltaTime, 0.0f));
+
+	// give the server time to write its results before the connections go away
+	if (SoakTime > Duration + 5.0f)
+		FPlatformMisc::RequestExit(false);
+}
+
+void UMovementSoakSubsystem::TickServer(float DeltaTime)
+{
+	UNetDriver* netDriver = GetWorld()->GetNetDriver();
+	if (SoakTime < 0.0f)
+	{
+		if (!netDriver || netDriver->ClientConnections.Num() == 0)
+			return;
+		SoakTime = 0.0f;
+		NextSampleTime = SampleInterval;
+	}
+
+	// the idle time is the wait for the next server tick, leave it out
+	const float frameTime = FMath::Max(DeltaTime - (float)FApp::GetIdleTime(), 0.0f);
+	FrameTimeSum += frameTime;
+	MaxFrameTime = FMath::Max(MaxFrameTime, frameTime);
+	FrameCount++;
+
+	SoakTime += DeltaTime;
+	if (SoakTime >= NextSampleTime)
+	{
+		SampleConnections();
+		NextSampleTime += SampleInterval;
+	}
+
+	if (SoakTime >= Duration)
+	{
+		const bool written = WriteResults();
+		FPlatformMisc::RequestExitWithStatus(false, written ? 0 : 1);
+		SoakTime = -1.0f;
+		bServer = false;
+	}
+}
+
+void UMovementSoakSubsystem::SampleConnections()
+{
+	UNetDriver* netDriver = GetWorld()->GetNetDriver();
+	if (!netDriver)
+		return;
+
+	const float frameTimeMs = FrameCount > 0 ? (float)(FrameTimeSum / FrameCount) * 1000.0f : 0.0f;
+	UGrappleRewindSubsystem* rewind = GetWorld()->GetSubsystem<UGrappleRewindSubsystem>();
+	const FGrappleValidationStats validations = rewind ? rewind->ConsumeValidationStats() : FGrappleValidationStats();
+	const int32 rewindMemory = rewind ? (int32)rewind->GetAllocatedSize() : 0;
+	for (int32 i = 0; i < netDriver->ClientConnections.Num(); i++)
+	{
+		UNetConnection* connection = netDriver->ClientConnections[i];
+		FMovementSoakSample& sample = Samples.AddDefaulted_GetRef();
+		sample.Time = SoakTime;
+		sample.Connection = i;
+		sample.FrameTimeMs = frameTimeMs;
+		sample.MaxFrameTimeMs = MaxFrameTime * 1000.0f;
+		sample.InBytesPerSecond = connection->InBytesPerSecond;
+		sample.OutBytesPerSecond = connection->OutBytesPerSecond;
+		sample.PingMs = (float)connection->AvgLag * 1000.0f;
+		sample.InPacketsLost = connection->InPacketsLost;
+		sample.OutPacketsLost = connection->OutPacketsLost;
+		sample.GrappleValidations = validations.Num();
+		sample.GrappleRejections = validations.Rejected;
+		sample.ValidationMeanUs = validations.Num() > 0 ? (float)(validations.ValidationTime / validations.Num() * 1000000.0) : 0.0f;
+		sample.ValidationMaxUs = (float)(validations.MaxValidationTime * 1000000.0);
+		sample.RewindMeanMs = validations.Num() > 0 ? (float)(validations.RewindTime / validations.Num() * 1000.0) : 0.0f;
+		sample.RewindMemoryBytes = rewindMemory;
+
+		APawn* pawn = connection->PlayerController ? connection->PlayerController->GetPawn() : nullptr;
+		if (UMovementMechanicsMovementComponent* movement = pawn ? Cast<UMovementMechanicsMovementComponent>(pawn->GetMovementComponent()) : nullptr)
+			sample.Corrections = movement->ConsumeServerCorrections();
+	}
+
+	FrameTimeSum = 0.0;
+	MaxFrameTime = 0.0f;
+	FrameCount = 0;
+}
+
+bool UMovementSoakSubsystem::WriteResults() const
+{
+	FString csv = TEXT("Time,Connection,FrameTimeMs,MaxFrameTimeMs,Corrections,InBytesPerSecond,OutBytesPerSecond,PingMs,InPacketsLost,OutPacketsLost,")
+		TEXT("GrappleValidations,GrappleRejections,ValidationMeanUs,ValidationMaxUs,RewindMeanMs,RewindMemoryBytes\n");
+	for (const FMovementSoakSample& s : Samples)
+	{
+		csv += FString::Printf(TEXT("%f,%d,%f,%f,%d,%d,%d,%f,%d,%d,%d,%d,%f,%f,%f,%d\n"), s.Time, s.Connection, s.FrameTimeMs, s.MaxFrameTimeMs,
+			s.Corrections, s.InBytesPerSecond, s.OutBytesPerSecond, s.PingMs, s.InPacketsLost, s.OutPacketsLost,
+			s.GrappleValidations, s.GrappleRejections, s.ValidationMeanUs, s.ValidationMaxUs, s.RewindMeanMs, s.RewindMemoryBytes);
+	}
+
+	if (OutputPath.IsEmpty() || !FFileHelper::SaveStringToFile(csv, *OutputPath))
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Could not write soak results to %s"), *OutputPath);
+		return false;
+	}
+	UE_LOG(LogMovementMechanics, Display, TEXT("Soak results written to %s"), *OutputPath);
+	return true;
+}
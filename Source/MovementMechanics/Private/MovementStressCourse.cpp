@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementStressCourse.h"
+#include "MovementMechanicsStats.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "UObject/ConstructorHelpers.h"
+
+AMovementStressCourse::AMovementStressCourse()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	Walls = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("Walls"));
+	Walls->SetupAttachment(RootComponent);
+	Walls->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Walls->SetMobility(EComponentMobility::Static);
+
+	Anchors = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("Anchors"));
+	Anchors->SetupAttachment(RootComponent);
+	Anchors->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Anchors->SetMobility(EComponentMobility::Static);
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> CubeMesh(TEXT("'/Game/LevelPrototyping/Meshes/SM_Cube.SM_Cube'"));
+	if (CubeMesh.Succeeded())
+	{
+		Walls->SetStaticMesh(CubeMesh.Object);
+		Anchors->SetStaticMesh(CubeMesh.Object);
+	}
+}
+
+void AMovementStressCourse::BeginPlay()
+{
+	Super::BeginPlay();
+	if (bGenerateOnBeginPlay)
+		Generate();
+}
+
+void AMovementStressCourse::Generate()
+{
+	Clear();
+	if (!Walls->GetStaticMesh() || !Anchors->GetStaticMesh())
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Stress course has no mesh"));
+		return;
+	}
+
+	// everything is drawn from one stream in a fixed order, so the seed decides the whole course
+	FRandomStream random(Seed);
+	TArray<FTransform> wallTransforms;
+	TArray<FTransform> anchorTransforms;
+
+	// walls, local space, x along the course and y across it
+	const int32 laneCount = FMath::Max(FMath::FloorToInt(CourseWidth / LaneSpacing), 1);
+	const int32 cellCount = FMath::Max(FMath::FloorToInt((CourseLength - StartClearance) / CellLength), 0);
+	for (int32 lane = 0; lane < laneCount; lane++)
+	{
+		const float y = (lane + 0.5f) * LaneSpacing - CourseWidth * 0.5f;
+		for (int32 cell = 0; cell < cellCount; cell++)
+		{
+			// always draw the same numbers per cell so changing the density doesn't move the other walls
+			const float roll = random.FRand();
+			const float height = random.FRandRange(MinWallHeight, MaxWallHeight);
+			const float length = FMath::Min(random.FRandRange(MinWallLength, MaxWallLength), CellLength);
+			const float yaw = random.FRandRange(-MaxWallYaw, MaxWallYaw);
+			if (roll >= WallDensity)
+				continue;
+
+			const FVector center(StartClearance + (cell + 0.5f) * CellLength, y, height * 0.5f);
+			wallTransforms.Add(FitMeshToBox(Walls->GetStaticMesh(), center, FVector(length, WallThickness, height), FRotator(0.0f, yaw, 0.0f)));
+		}
+	}
+
+	// anchors on a jittered grid above the walls
+	const int32 anchorRows = FMath::Max(FMath::FloorToInt((CourseLength - StartClearance) / AnchorSpacing), 0);
+	const int32 anchorColumns = FMath::Max(FMath::FloorToInt(CourseWidth / AnchorSpacing), 1);
+	for (int32 row = 0; row < anchorRows; row++)
+	{
+		for (int32 column = 0; column < anchorColumns; column++)
+		{
+			const FVector jitter = FVector(random.FRandRange(-1.0f, 1.0f), random.FRandRange(-1.0f, 1.0f), random.FRandRange(-1.0f, 1.0f)) * AnchorJitter;
+			const FVector center = FVector(StartClearance + (row + 0.5f) * AnchorSpacing, (column + 0.5f) * AnchorSpacing - CourseWidth * 0.5f, AnchorHeight) + jitter;
+			anchorTransforms.Add(FitMeshToBox(Anchors->GetStaticMesh(), center, FVector(AnchorSize), FRotator::ZeroRotator));
+		}
+	}
+
+	Walls->AddInstances(wallTransforms, false);
+	Anchors->AddInstances(anchorTransforms, false);
+
+	CourseHash = FCrc::MemCrc32(wallTransforms.GetData(), wallTransforms.Num() * sizeof(FTransform));
+	CourseHash = FCrc::MemCrc32(anchorTransforms.GetData(), anchorTransforms.Num() * sizeof(FTransform), CourseHash);
+	UE_LOG(LogMovementMechanics, Display, TEXT("Stress course seed %d: %d walls, %d anchors, hash %08x"), Seed, wallTransforms.Num(), anchorTransforms.Num(), CourseHash);
+}
+
+void AMovementStressCourse::Clear()
+{
+	Modify();
+	Walls->ClearInstances();
+	Anchors->ClearInstances();
+	CourseHash = 0;
+}
+
+int32 AMovementStressCourse::GetWallCount() const
+{
+	return Walls->GetInstanceCount();
+}
+
+int32 AMovementStressCourse::GetAnchorCount() const
+{
+	return Anchors->GetInstanceCount();
+}
+
+FTransform AMovementStressCourse::FitMeshToBox(const UStaticMesh* Mesh, const FVector& Center, const FVector& Size, const FRotator& Rotation)
+{
+	const FBox bounds = Mesh->GetBoundingBox();
+	const FVector scale = Size / bounds.GetSize().ComponentMax(FVector(KINDA_SMALL_NUMBER));
+	// move the pivot so the middle of the mesh bounds ends up on Center
+	const FVector location = Center - Rotation.RotateVector(bounds.GetCenter() * scale);
+	return FTransform(Rotation, location, scale);
+}
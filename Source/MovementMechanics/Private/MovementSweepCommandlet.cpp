@@ -0,0 +1,352 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementSweepCommandlet.h"
+#include "MovementMechanicsStats.h"
+#include "MovementSimulation.h"
+#include "MovementMechanicsCharacter.h"
+#include "GrapplingHookComponent.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UMovementSweepCommandlet::UMovementSweepCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UMovementSweepCommandlet::Main(const FString& Params)
+{
+	FString outputPath;
+	if (!FParse::Value(*Params, TEXT("Params="), ParamsPath) || !FParse::Value(*Params, TEXT("Script="), ScriptPath) || !FParse::Value(*Params, TEXT("Output="), outputPath))
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("MovementSweep needs -Params=, -Script= and -Output="));
+		return 1;
+	}
+	ParamsPath = FPaths::ConvertRelativePathToFull(ParamsPath);
+	ScriptPath = FPaths::ConvertRelativePathToFull(ScriptPath);
+	outputPath = FPaths::ConvertRelativePathToFull(outputPath);
+
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Pawn="), PawnClassName);
+	FParse::Value(*Params, TEXT("Timestep="), Timestep);
+	FParse::Value(*Params, TEXT("MaxTime="), MaxTime);
+	FParse::Value(*Params, TEXT("Worlds="), WorldsPerBatch);
+	FParse::Value(*Params, TEXT("GoalRadius="), GoalRadius);
+	FString goalString;
+	if (FParse::Value(*Params, TEXT("Goal="), goalString, false))
+	{
+		TArray<FString> components;
+		goalString.ParseIntoArray(components, TEXT(","));
+		if (components.Num() == 3)
+			Goal = FVector(FCString::Atof(*components[0]), FCString::Atof(*components[1]), FCString::Atof(*components[2]));
+	}
+
+	WorldsPerBatch = FMath::Max(WorldsPerBatch, 1);
+
+	TArray<FMovementSweepParams> sweepParams;
+	TArray<FMovementSweepEvent> script;
+	if (!LoadParams(ParamsPath, sweepParams) || !LoadScript(ScriptPath, script))
+		return 1;
+
+	// worlds can only be ticked from the game thread, so to use every core the sweep is split
+	// into shards and one process is started per shard
+	int32 shardCount = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+	FParse::Value(*Params, TEXT("ShardCount="), shardCount);
+	shardCount = FMath::Clamp(shardCount, 1, sweepParams.Num());
+	int32 shard = 0;
+	if (FParse::Value(*Params, TEXT("Shard="), shard))
+		return RunShard(sweepParams, script, shard, shardCount, outputPath);
+	if (shardCount == 1)
+		return RunShard(sweepParams, script, 0, 1, outputPath);
+	return RunShards(shardCount, outputPath);
+}
+
+int32 UMovementSweepCommandlet::RunShard(const TArray<FMovementSweepParams>& sweepParams, const TArray<FMovementSweepEvent>& script, int32 shard, int32 shardCount, const FString& outputPath)
+{
+	UWorld* templateWorld = MovementSimulation::LoadTemplateWorld(MapName);
+	if (!templateWorld)
+		return 1;
+
+	TArray<int32> runIndices;
+	for (int32 i = shard; i < sweepParams.Num(); i += shardCount)
+		runIndices.Add(i);
+
+	TArray<FMovementSweepResult> results;
+	results.SetNum(sweepParams.Num());
+
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(Timestep);
+	const double startTime = FPlatformTime::Seconds();
+
+	for (int32 batchStart = 0; batchStart < runIndices.Num(); batchStart += WorldsPerBatch)
+	{
+		const int32 batchSize = FMath::Min(WorldsPerBatch, runIndices.Num() - batchStart);
+
+		TArray<UWorld*> worlds;
+		TArray<AMovementMechanicsCharacter*> characters;
+		TArray<int32> nextEvent;
+		TArray<FVector> lastLocation;
+		for (int32 i = 0; i < batchSize; i++)
+		{
+			UWorld* world = MovementSimulation::CreateWorld(templateWorld, batchStart + i);
+			worlds.Add(world);
+			AMovementMechanicsCharacter* character = SpawnCharacter(world, sweepParams[runIndices[batchStart + i]]);
+			characters.Add(character);
+			nextEvent.Add(0);
+			lastLocation.Add(character ? character->GetActorLocation() : FVector::ZeroVector);
+		}
+
+		// step every world of the batch with the same fixed timestep until all of them finish
+		for (float time = 0.0f; time < MaxTime; time += Timestep)
+		{
+			bool anyRunning = false;
+			FApp::SetDeltaTime(Timestep);
+			for (int32 i = 0; i < batchSize; i++)
+			{
+				AMovementMechanicsCharacter* character = characters[i];
+				FMovementSweepResult& result = results[runIndices[batchStart + i]];
+				if (!character || result.CompletionTime >= 0.0f)
+					continue;
+				anyRunning = true;
+
+				while (nextEvent[i] < script.Num() && script[nextEvent[i]].Time <= time)
+				{
+					ApplyEvent(character, script[nextEvent[i]]);
+					nextEvent[i]++;
+				}
+
+				worlds[i]->Tick(LEVELTICK_All, Timestep);
+
+				const FVector location = character->GetActorLocation();
+				result.DistanceTravelled += FVector::Distance(location, lastLocation[i]);
+				result.MaxSpeed = FMath::Max(result.MaxSpeed, character->GetVelocity().Size());
+				if (character->IsWallRunning())
+					result.WallRunTime += Timestep;
+				if (character->GrappleHookComponent && character->GrappleHookComponent->IsGrappleAttached())
+					result.GrappleTime += Timestep;
+				result.FinalLocation = location;
+				lastLocation[i] = location;
+
+				if (FVector::Distance(location, Goal) <= GoalRadius)
+					result.CompletionTime = time + Timestep;
+			}
+			GFrameCounter++;
+
+			if (!anyRunning)
+				break;
+		}
+
+		for (UWorld* world : worlds)
+			MovementSimulation::DestroyWorld(world);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+		UE_LOG(LogMovementMechanics, Display, TEXT("MovementSweep %d/%d runs done"), batchStart + batchSize, runIndices.Num());
+	}
+
+	FString csv = TEXT("Index,GrappleSpeed,PullInitialSpeed,PerTickPulForce,WalkingSpeed,GravityScale,WallHeight,CompletionTime,DistanceTravelled,MaxSpeed,WallRunTime,GrappleTime,FinalX,FinalY,FinalZ\n");
+	for (int32 index : runIndices)
+	{
+		const FMovementSweepParams& p = sweepParams[index];
+		const FMovementSweepResult& r = results[index];
+		csv += FString::Printf(TEXT("%d,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f\n"), index,
+			p.GrappleSpeed, p.PullInitialSpeed, p.PerTickPulForce, p.WalkingSpeed, p.GravityScale, p.WallHeight,
+			r.CompletionTime, r.DistanceTravelled, r.MaxSpeed, r.WallRunTime, r.GrappleTime,
+			r.FinalLocation.X, r.FinalLocation.Y, r.FinalLocation.Z);
+	}
+
+	if (!FFileHelper::SaveStringToFile(csv, *outputPath))
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Could not write %s"), *outputPath);
+		return 1;
+	}
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("MovementSweep finished %d runs in %.2f seconds"), runIndices.Num(), FPlatformTime::Seconds() - startTime);
+	return 0;
+}
+
+int32 UMovementSweepCommandlet::RunShards(int32 ShardCount, const FString& OutputPath)
+{
+	const double startTime = FPlatformTime::Seconds();
+	const FString goal = FString::Printf(TEXT("%f,%f,%f"), Goal.X, Goal.Y, Goal.Z);
+
+	TArray<FProcHandle> shards;
+	for (int32 shard = 0; shard < ShardCount; shard++)
+	{
+		// the same executable, headless and without any prompts
+		const FString commandLine = FString::Printf(TEXT("\"%s\" -run=MovementSweep -Params=\"%s\" -Script=\"%s\" -Output=\"%s\" -Goal=%s -GoalRadius=%f ")
+			TEXT("-Map=%s -Pawn=%s -Timestep=%f -MaxTime=%f -Worlds=%d -Shard=%d -ShardCount=%d -nullrhi -unattended -nosplash -log=MovementSweepShard%d.log"),
+			*FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()), *ParamsPath, *ScriptPath, *GetShardOutputPath(OutputPath, shard), *goal, GoalRadius,
+			*MapName, *PawnClassName, Timestep, MaxTime, WorldsPerBatch, shard, ShardCount, shard);
+		UE_LOG(LogMovementMechanics, Display, TEXT("Starting %s"), *commandLine);
+		shards.Add(FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *commandLine, false, true, true, nullptr, 0, nullptr, nullptr));
+		if (!shards.Last().IsValid())
+			UE_LOG(LogMovementMechanics, Error, TEXT("Could not start sweep shard %d"), shard);
+	}
+
+	int32 failures = 0;
+	for (int32 shard = 0; shard < ShardCount; shard++)
+	{
+		FProcHandle& process = shards[shard];
+		if (!process.IsValid())
+		{
+			failures++;
+			continue;
+		}
+		FPlatformProcess::WaitForProc(process);
+		int32 returnCode = 1;
+		if (!FPlatformProcess::GetProcReturnCode(process, &returnCode) || returnCode != 0)
+		{
+			UE_LOG(LogMovementMechanics, Error, TEXT("Sweep shard %d failed, see MovementSweepShard%d.log"), shard, shard);
+			failures++;
+		}
+		FPlatformProcess::CloseProc(process);
+	}
+	if (failures > 0)
+		return 1;
+
+	// every shard writes the header, keep the first and order the rows by parameter index
+	FString header;
+	TArray<TPair<int32, FString>> rows;
+	for (int32 shard = 0; shard < ShardCount; shard++)
+	{
+		const FString shardPath = GetShardOutputPath(OutputPath, shard);
+		TArray<FString> lines;
+		if (!FFileHelper::LoadFileToStringArray(lines, *shardPath) || lines.Num() == 0)
+		{
+			UE_LOG(LogMovementMechanics, Error, TEXT("Could not read %s"), *shardPath);
+			return 1;
+		}
+		header = lines[0];
+		for (int32 i = 1; i < lines.Num(); i++)
+		{
+			if (!lines[i].IsEmpty())
+				rows.Emplace(FCString::Atoi(*lines[i]), lines[i]);
+		}
+		IFileManager::Get().Delete(*shardPath);
+	}
+	rows.Sort([](const TPair<int32, FString>& A, const TPair<int32, FString>& B) { return A.Key < B.Key; });
+
+	FString csv = header + TEXT("\n");
+	for (const TPair<int32, FString>& row : rows)
+		csv += row.Value + TEXT("\n");
+	if (!FFileHelper::SaveStringToFile(csv, *OutputPath))
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Could not write %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogMovementMechanics, Display, TEXT("MovementSweep finished %d runs in %d processes in %.2f seconds"), rows.Num(), ShardCount, FPlatformTime::Seconds() - startTime);
+	return 0;
+}
+
+FString UMovementSweepCommandlet::GetShardOutputPath(const FString& OutputPath, int32 Shard) const
+{
+	return FPaths::GetPath(OutputPath) / FString::Printf(TEXT("%s.Shard%d.csv"), *FPaths::GetBaseFilename(OutputPath), Shard);
+}
+
+bool UMovementSweepCommandlet::LoadParams(const FString& Path, TArray<FMovementSweepParams>& OutParams)
+{
+	TArray<FString> lines;
+	if (!FFileHelper::LoadFileToStringArray(lines, *Path))
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Could not read %s"), *Path);
+		return false;
+	}
+
+	for (const FString& line : lines)
+	{
+		TArray<FString> values;
+		line.ParseIntoArray(values, TEXT(","));
+		// skip headers and malformed lines
+		if (values.Num() != 6 || !values[0].IsNumeric())
+			continue;
+
+		FMovementSweepParams params;
+		params.GrappleSpeed = FCString::Atof(*values[0]);
+		params.PullInitialSpeed = FCString::Atof(*values[1]);
+		params.PerTickPulForce = FCString::Atof(*values[2]);
+		params.WalkingSpeed = FCString::Atof(*values[3]);
+		params.GravityScale = FCString::Atof(*values[4]);
+		params.WallHeight = FCString::Atof(*values[5]);
+		OutParams.Add(params);
+	}
+	return OutParams.Num() > 0;
+}
+
+bool UMovementSweepCommandlet::LoadScript(const FString& Path, TArray<FMovementSweepEvent>& OutScript)
+{
+	TArray<FString> lines;
+	if (!FFileHelper::LoadFileToStringArray(lines, *Path))
+	{
+		UE_LOG(LogMovementMechanics, Error, TEXT("Could not read %s"), *Path);
+		return false;
+	}
+
+	for (const FString& line : lines)
+	{
+		TArray<FString> tokens;
+		line.ParseIntoArrayWS(tokens);
+		if (tokens.Num() < 2 || tokens[0].StartsWith(TEXT("#")))
+			continue;
+
+		FMovementSweepEvent event;
+		event.Time = FCString::Atof(*tokens[0]);
+		event.Action = FName(*tokens[1]);
+		event.Value = tokens.Num() > 2 ? FCString::Atof(*tokens[2]) : 1.0f;
+		OutScript.Add(event);
+	}
+
+	OutScript.StableSort([](const FMovementSweepEvent& A, const FMovementSweepEvent& B) { return A.Time < B.Time; });
+	return true;
+}
+
+AMovementMechanicsCharacter* UMovementSweepCommandlet::SpawnCharacter(UWorld* World, const FMovementSweepParams& SweepParams)
+{
+	AMovementMechanicsCharacter* character = MovementSimulation::SpawnScriptedCharacter(World, PawnClassName, MovementSimulation::FindSpawnTransform(World));
+	if (!character)
+		return nullptr;
+
+	character->WalkingSpeed = SweepParams.WalkingSpeed;
+	character->GravityScale = SweepParams.GravityScale;
+	character->WallHeight = SweepParams.WallHeight;
+	if (character->GrappleHookComponent)
+	{
+		character->GrappleHookComponent->GrappleSpeed = SweepParams.GrappleSpeed;
+		character->GrappleHookComponent->PullInitialSpeed = SweepParams.PullInitialSpeed;
+		character->GrappleHookComponent->PerTickPulForce = SweepParams.PerTickPulForce;
+	}
+	return character;
+}
+
+void UMovementSweepCommandlet::ApplyEvent(AMovementMechanicsCharacter* Character, const FMovementSweepEvent& Event)
+{
+	static const FName ForwardName(TEXT("Forward"));
+	static const FName RightName(TEXT("Right"));
+	static const FName JumpName(TEXT("Jump"));
+	static const FName GrappleName(TEXT("Grapple"));
+	static const FName TurnName(TEXT("Turn"));
+
+	if (Event.Action == ForwardName)
+		Character->SetScriptedAxes(Event.Value, Character->ScriptedRightAxis);
+	else if (Event.Action == RightName)
+		Character->SetScriptedAxes(Character->ScriptedForwardAxis, Event.Value);
+	else if (Event.Action == JumpName)
+		Character->ScriptedJump();
+	else if (Event.Action == GrappleName)
+		Character->ScriptedGrapple();
+	else if (Event.Action == TurnName)
+	{
+		// turn the controller by Value degrees of yaw
+		if (AController* controller = Character->GetController())
+			controller->SetControlRotation(controller->GetControlRotation() + FRotator(0.0f, Event.Value, 0.0f));
+	}
+	else
+		UE_LOG(LogMovementMechanics, Warning, TEXT("Unknown sweep action %s"), *Event.Action.ToString());
+}
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementTimerBenchmarkCommandlet.h"
+#include "MovementMechanicsStats.h"
+#include "MovementBenchmarkCommandlet.h"
+#include "Dom/JsonObject.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	// what an object checking its own expiry every tick costs, one heap object and a virtual call each
+	class FTickedExpiry
+	{
+	public:
+		virtual ~FTickedExpiry() {}
+
+		virtual void Tick(float DeltaSeconds, int32& Expired)
+		{
+			Remaining -= DeltaSeconds;
+			if (Remaining <= 0.0f)
+			{
+				Expired++;
+				Remaining = Delay;
+			}
+		}
+
+		float Delay = 0.0f;
+		float Remaining = 0.0f;
+	};
+}
+
+UMovementTimerBenchmarkCommandlet::UMovementTimerBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UMovementTimerBenchmarkCommandlet::Main(const FString& Params)
+{
+	FParse::Value(*Params, TEXT("Timers="), Timers);
+	FParse::Value(*Params, TEXT("Frames="), Frames);
+	FParse::Value(*Params, TEXT("Timestep="), Timestep);
+	FParse::Value(*Params, TEXT("CancelsPerFrame="), CancelsPerFrame);
+	FParse::Value(*Params, TEXT("MinDelay="), MinDelay);
+	FParse::Value(*Params, TEXT("MaxDelay="), MaxDelay);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	// both runs use the same delays
+	FRandomStream random(Seed);
+	Delays.SetNumUninitialized(Timers);
+	for (float& delay : Delays)
+		delay = random.FRandRange(MinDelay, MaxDelay);
+
+	TArray<double> wheelSamples;
+	RunWheel(wheelSamples);
+	const int32 wheelExpired = Expired;
+	TArray<double> tickedSamples;
+	RunTicked(tickedSamples);
+	const int32 tickedExpired = Expired;
+
+	TSharedPtr<FJsonObject> wheelResult = UMovementBenchmarkCommandlet::MakeTimerResult(wheelSamples);
+	TSharedPtr<FJsonObject> tickedResult = UMovementBenchmarkCommandlet::MakeTimerResult(tickedSamples);
+	wheelResult->SetNumberField(TEXT("Expired"), wheelExpired);
+	tickedResult->SetNumberField(TEXT("Expired"), tickedExpired);
+	UE_LOG(LogMovementMechanics, Display, TEXT("%d timers, %d frames: wheel %.2fus mean %.2fus p99, ticked %.2fus mean %.2fus p99"), Timers, Frames,
+		wheelResult->GetNumberField(TEXT("Mean")), wheelResult->GetNumberField(TEXT("P99")),
+		tickedResult->GetNumberField(TEXT("Mean")), tickedResult->GetNumberField(TEXT("P99")));
+	UE_LOG(LogMovementMechanics, Display, TEXT("Expired: wheel %d, ticked %d"), wheelExpired, tickedExpired);
+
+	FString outputPath;
+	if (FParse::Value(*Params, TEXT("Output="), outputPath))
+	{
+		TSharedPtr<FJsonObject> results = MakeShared<FJsonObject>();
+		results->SetNumberField(TEXT("Timers"), Timers);
+		results->SetNumberField(TEXT("Frames"), Frames);
+		results->SetNumberField(TEXT("Timestep"), Timestep);
+		results->SetNumberField(TEXT("CancelsPerFrame"), CancelsPerFrame);
+		results->SetObjectField(TEXT("Wheel"), wheelResult);
+		results->SetObjectField(TEXT("Ticked"), tickedResult);
+
+		FString json;
+		TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+		FJsonSerializer::Serialize(results.ToSharedRef(), writer);
+		if (!FFileHelper::SaveStringToFile(json, *outputPath))
+		{
+			UE_LOG(LogMovementMechanics, Error, TEXT("Could not write %s"), *outputPath);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void UMovementTimerBenchmarkCommandlet::RunWheel(TArray<double>& OutFrameSamples)
+{
+	Wheel.Reset();
+	Expired = 0;
+	Handles.SetNum(Timers);
+	for (int32 i = 0; i < Timers; i++)
+		Handles[i] = Wheel.Schedule(Delays[i], FMovementTimerCallback::Create<UMovementTimerBenchmarkCommandlet, &UMovementTimerBenchmarkCommandlet::OnWheelTimer>(this, i));
+
+	FRandomStream cancels(Seed);
+	OutFrameSamples.Reserve(Frames);
+	for (int32 frame = 0; frame < Frames; frame++)
+	{
+		const double start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < CancelsPerFrame; i++)
+		{
+			const int32 index = cancels.RandHelper(Timers);
+			Wheel.Cancel(Handles[index]);
+			Handles[index] = Wheel.Schedule(Delays[index], FMovementTimerCallback::Create<UMovementTimerBenchmarkCommandlet, &UMovementTimerBenchmarkCommandlet::OnWheelTimer>(this, index));
+		}
+		Wheel.Advance(Timestep);
+		OutFrameSamples.Add((FPlatformTime::Seconds() - start) * 1000000.0);
+	}
+	Wheel.Reset();
+}
+
+void UMovementTimerBenchmarkCommandlet::OnWheelTimer(int32 Index)
+{
+	Expired++;
+	Handles[Index] = Wheel.Schedule(Delays[Index], FMovementTimerCallback::Create<UMovementTimerBenchmarkCommandlet, &UMovementTimerBenchmarkCommandlet::OnWheelTimer>(this, Index));
+}
+
+void UMovementTimerBenchmarkCommandlet::RunTicked(TArray<double>& OutFrameSamples)
+{
+	Expired = 0;
+	TArray<TUniquePtr<FTickedExpiry>> objects;
+	objects.Reserve(Timers);
+	for (int32 i = 0; i < Timers; i++)
+	{
+		TUniquePtr<FTickedExpiry> object = MakeUnique<FTickedExpiry>();
+		object->Delay = Delays[i];
+		object->Remaining = Delays[i];
+		objects.Add(MoveTemp(object));
+	}
+
+	FRandomStream cancels(Seed);
+	OutFrameSamples.Reserve(Frames);
+	for (int32 frame = 0; frame < Frames; frame++)
+	{
+		const double start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < CancelsPerFrame; i++)
+		{
+			FTickedExpiry& object = *objects[cancels.RandHelper(Timers)];
+			object.Remaining = object.Delay;
+		}
+		for (const TUniquePtr<FTickedExpiry>& object : objects)
+			object->Tick(Timestep, Expired);
+		OutFrameSamples.Add((FPlatformTime::Seconds() - start) * 1000000.0);
+	}
+}
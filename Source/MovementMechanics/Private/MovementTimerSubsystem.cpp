@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementTimerSubsystem.h"
+#include "MovementMechanicsStats.h"
+
+FMovementTimerWheel::FMovementTimerWheel()
+{
+	for (int32& head : SlotHeads)
+		head = INDEX_NONE;
+}
+
+FMovementTimerHandle FMovementTimerWheel::Schedule(float Delay, const FMovementTimerCallback& Callback)
+{
+	int32 index = FreeHead;
+	if (index != INDEX_NONE)
+		FreeHead = Nodes[index].Next;
+	else
+		index = Nodes.AddDefaulted();
+
+	// at least one tick away, the current one has already fired
+	const uint64 ticks = (uint64)FMath::Max(1.0f, FMath::CeilToFloat((Accumulator + FMath::Max(Delay, 0.0f)) / TickSeconds));
+	FNode& node = Nodes[index];
+	node.Callback = Callback;
+	node.ExpireTick = CurrentTick + FMath::Min(ticks, MaxTicks - 1);
+	Link(index);
+	NumScheduled++;
+
+	FMovementTimerHandle handle;
+	handle.Index = index;
+	handle.Serial = node.Serial;
+	return handle;
+}
+
+bool FMovementTimerWheel::Cancel(FMovementTimerHandle& Handle)
+{
+	const bool scheduled = IsScheduled(Handle);
+	if (scheduled)
+	{
+		Unlink(Handle.Index);
+		FreeNode(Handle.Index);
+	}
+	Handle.Invalidate();
+	return scheduled;
+}
+
+bool FMovementTimerWheel::IsScheduled(const FMovementTimerHandle& Handle) const
+{
+	return Nodes.IsValidIndex(Handle.Index) && Nodes[Handle.Index].Serial == Handle.Serial && Nodes[Handle.Index].Slot != INDEX_NONE;
+}
+
+int32 FMovementTimerWheel::Advance(float DeltaSeconds)
+{
+	int32 fired = 0;
+	Accumulator += DeltaSeconds;
+	while (Accumulator >= TickSeconds)
+	{
+		Accumulator -= TickSeconds;
+		CurrentTick++;
+
+		// the root wheel wrapped, refill it from the coarser ones
+		if ((CurrentTick & (RootSlots - 1)) == 0)
+		{
+			for (int32 level = 1; level < Levels; level++)
+			{
+				if (Cascade(level) != 0)
+					break;
+			}
+		}
+
+		if (NumScheduled > 0)
+			fired += FireSlot((int32)(CurrentTick & (RootSlots - 1)));
+	}
+	return fired;
+}
+
+void FMovementTimerWheel::Reset()
+{
+	Nodes.Reset();
+	Batch.Reset();
+	FreeHead = INDEX_NONE;
+	for (int32& head : SlotHeads)
+		head = INDEX_NONE;
+	NumScheduled = 0;
+}
+
+SIZE_T FMovementTimerWheel::GetAllocatedSize() const
+{
+	return Nodes.GetAllocatedSize() + Batch.GetAllocatedSize();
+}
+
+int32 FMovementTimerWheel::SlotFor(uint64 ExpireTick) const
+{
+	const uint64 delta = ExpireTick - CurrentTick;
+	if (delta < RootSlots)
+		return (int32)(ExpireTick & (RootSlots - 1));
+
+	// coarser wheels, each slot covers a whole turn of the wheel below
+	for (int32 level = 1; level < Levels; level++)
+	{
+		const int32 shift = RootBits + (level - 1) * LevelBits;
+		if (delta < (1ull << (shift + LevelBits)) || level == Levels - 1)
+			return RootSlots + (level - 1) * LevelSlots + (int32)((ExpireTick >> shift) & (LevelSlots - 1));
+	}
+	return INDEX_NONE;
+}
+
+void FMovementTimerWheel::Link(int32 NodeIndex)
+{
+	FNode& node = Nodes[NodeIndex];
+	node.Slot = SlotFor(node.ExpireTick);
+	node.Prev = INDEX_NONE;
+	node.Next = SlotHeads[node.Slot];
+	if (node.Next != INDEX_NONE)
+		Nodes[node.Next].Prev = NodeIndex;
+	SlotHeads[node.Slot] = NodeIndex;
+}
+
+void FMovementTimerWheel::Unlink(int32 NodeIndex)
+{
+	FNode& node = Nodes[NodeIndex];
+	if (node.Prev != INDEX_NONE)
+		Nodes[node.Prev].Next = node.Next;
+	else
+		SlotHeads[node.Slot] = node.Next;
+	if (node.Next != INDEX_NONE)
+		Nodes[node.Next].Prev = node.Prev;
+}
+
+void FMovementTimerWheel::FreeNode(int32 NodeIndex)
+{
+	FNode& node = Nodes[NodeIndex];
+	node.Callback = FMovementTimerCallback();
+	node.Slot = INDEX_NONE;
+	// handles to the old timer stop matching
+	node.Serial++;
+	node.Next = FreeHead;
+	FreeHead = NodeIndex;
+	NumScheduled--;
+}
+
+int32 FMovementTimerWheel::Cascade(int32 Level)
+{
+	const int32 shift = RootBits + (Level - 1) * LevelBits;
+	const int32 position = (int32)((CurrentTick >> shift) & (LevelSlots - 1));
+	const int32 slot = RootSlots + (Level - 1) * LevelSlots + position;
+
+	int32 index = SlotHeads[slot];
+	SlotHeads[slot] = INDEX_NONE;
+	while (index != INDEX_NONE)
+	{
+		const int32 next = Nodes[index].Next;
+		Link(index);
+		index = next;
+	}
+	return position;
+}
+
+int32 FMovementTimerWheel::FireSlot(int32 Slot)
+{
+	// take the whole slot out first, the callbacks may change the wheel
+	Batch.Reset();
+	int32 index = SlotHeads[Slot];
+	SlotHeads[Slot] = INDEX_NONE;
+	while (index != INDEX_NONE)
+	{
+		const int32 next = Nodes[index].Next;
+		Batch.Add(Nodes[index].Callback);
+		FreeNode(index);
+		index = next;
+	}
+
+	const int32 fired = Batch.Num();
+	for (const FMovementTimerCallback& callback : Batch)
+		callback.ExecuteIfValid();
+	return fired;
+}
+
+FMovementTimerHandle UMovementTimerSubsystem::Schedule(float Delay, const FMovementTimerCallback& Callback)
+{
+	LLM_SCOPE_BYTAG(MovementSubsystems);
+	return Wheel.Schedule(Delay, Callback);
+}
+
+bool UMovementTimerSubsystem::Cancel(FMovementTimerHandle& Handle)
+{
+	return Wheel.Cancel(Handle);
+}
+
+void UMovementTimerSubsystem::Deinitialize()
+{
+	Wheel.Reset();
+	Super::Deinitialize();
+}
+
+void UMovementTimerSubsystem::Tick(float DeltaTime)
+{
+	LLM_SCOPE_BYTAG(MovementSubsystems);
+	SCOPE_CYCLE_COUNTER(STAT_MovementTimerWheel);
+	Wheel.Advance(DeltaTime);
+	SET_DWORD_STAT(STAT_MovementTimersScheduled, Wheel.Num());
+}
+
+TStatId UMovementTimerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMovementTimerSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementTuningCurve.h"
+#include "Curves/CurveFloat.h"
+
+void FBakedMovementCurve::Bake(const UCurveFloat* Curve, float DefaultValue)
+{
+	float minTime = 0.0f;
+	float maxTime = 0.0f;
+	if (Curve)
+		Curve->GetTimeRange(minTime, maxTime);
+
+	StartTime = minTime;
+	InvStep = maxTime > minTime ? (NumSamples - 1) / (maxTime - minTime) : 0.0f;
+	for (int32 i = 0; i < NumSamples; i++)
+	{
+		const float time = InvStep > 0.0f ? minTime + i / InvStep : minTime;
+		Samples[i] = Curve ? Curve->GetFloatValue(time) : DefaultValue;
+	}
+}
@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickUpProximitySubsystem.h"
+#include "TP_PickUpComponent.h"
+#include "MovementMechanicsCharacter.h"
+#include "MovementMechanicsStats.h"
+#include "Components/CapsuleComponent.h"
+#include "EngineUtils.h"
+
+void UPickUpProximitySubsystem::RegisterPickUp(UTP_PickUpComponent* PickUp)
+{
+	if (!PickUp || EntryIndices.Contains(PickUp))
+		return;
+
+	FPickUpEntry entry;
+	entry.Location = PickUp->GetComponentLocation();
+	entry.Radius = PickUp->GetScaledSphereRadius();
+	entry.Cell = GetCell(entry.Location);
+	entry.PickUp = PickUp;
+
+	int32 index = Entries.Add(entry);
+	TArray<int32>& cell = Cells.FindOrAdd(entry.Cell);
+	const SIZE_T cellBytes = cell.GetAllocatedSize();
+	cell.Add(index);
+	CellArrayBytes += cell.GetAllocatedSize() - cellBytes;
+	EntryIndices.Add(PickUp, index);
+	MaxRadius = FMath::Max(MaxRadius, entry.Radius);
+
+	INC_DWORD_STAT(STAT_PickUpsRegistered);
+	UpdateMemoryStat();
+}
+
+void UPickUpProximitySubsystem::UnregisterPickUp(UTP_PickUpComponent* PickUp)
+{
+	int32 index;
+	if (EntryIndices.RemoveAndCopyValue(PickUp, index))
+		RemoveEntry(index);
+}
+
+void UPickUpProximitySubsystem::Tick(float DeltaTime)
+{
+	LLM_SCOPE_BYTAG(MovementSubsystems);
+	SCOPE_CYCLE_COUNTER(STAT_PickUpProximity);
+	LastTestCount = 0;
+	if (Entries.Num() == 0)
+		return;
+
+	int32 tests = 0;
+	for (TActorIterator<AMovementMechanicsCharacter> it(GetWorld()); it; ++it)
+	{
+		AMovementMechanicsCharacter* character = *it;
+		UCapsuleComponent* capsule = character->GetCapsuleComponent();
+		const FVector location = capsule->GetComponentLocation();
+		const float capsuleRadius = capsule->GetScaledCapsuleRadius();
+		const float halfHeight = capsule->GetScaledCapsuleHalfHeightWithoutHemisphere();
+		const FVector segmentStart = location - FVector(0.0f, 0.0f, halfHeight);
+		const FVector segmentEnd = location + FVector(0.0f, 0.0f, halfHeight);
+
+		// every cell that can hold a pick up touching the capsule
+		const FVector extent(capsuleRadius + MaxRadius, capsuleRadius + MaxRadius, halfHeight + capsuleRadius + MaxRadius);
+		const FIntVector minCell = GetCell(location - extent);
+		const FIntVector maxCell = GetCell(location + extent);
+
+		for (int32 x = minCell.X; x <= maxCell.X; x++)
+			for (int32 y = minCell.Y; y <= maxCell.Y; y++)
+				for (int32 z = minCell.Z; z <= maxCell.Z; z++)
+				{
+					TArray<int32>* cell = Cells.Find(FIntVector(x, y, z));
+					if (!cell)
+						continue;
+
+					for (int32 i = cell->Num() - 1; i >= 0; i--)
+					{
+						const int32 index = (*cell)[i];
+						const FPickUpEntry& entry = Entries[index];
+						tests++;
+
+						// sphere against capsule
+						const FVector closest = FMath::ClosestPointOnSegment(entry.Location, segmentStart, segmentEnd);
+						if (FVector::DistSquared(closest, entry.Location) > FMath::Square(entry.Radius + capsuleRadius))
+							continue;
+
+						PickedUp.Emplace(entry.PickUp, character);
+						EntryIndices.Remove(entry.PickUp);
+						RemoveEntry(index);
+						// the cell array is removed with its last entry
+						cell = Cells.Find(FIntVector(x, y, z));
+						if (!cell)
+							break;
+					}
+				}
+	}
+	SET_DWORD_STAT(STAT_PickUpProximityTests, tests);
+	LastTestCount = tests;
+
+	// broadcast after the search, listeners may register or remove pick ups
+	for (const TPair<TWeakObjectPtr<UTP_PickUpComponent>, AMovementMechanicsCharacter*>& pickUp : PickedUp)
+	{
+		if (UTP_PickUpComponent* component = pickUp.Key.Get())
+			component->NotifyPickedUp(pickUp.Value);
+	}
+	PickedUp.Reset();
+}
+
+TStatId UPickUpProximitySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPickUpProximitySubsystem, STATGROUP_Tickables);
+}
+
+FIntVector UPickUpProximitySubsystem::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void UPickUpProximitySubsystem::RemoveEntry(int32 Index)
+{
+	const FIntVector cellKey = Entries[Index].Cell;
+	if (TArray<int32>* cell = Cells.Find(cellKey))
+	{
+		const SIZE_T cellBytes = cell->GetAllocatedSize();
+		cell->RemoveSingleSwap(Index);
+		CellArrayBytes -= cellBytes;
+		if (cell->Num() == 0)
+			Cells.Remove(cellKey);
+		else
+			CellArrayBytes += cell->GetAllocatedSize();
+	}
+	Entries.RemoveAt(Index);
+
+	DEC_DWORD_STAT(STAT_PickUpsRegistered);
+	UpdateMemoryStat();
+}
+
+SIZE_T UPickUpProximitySubsystem::GetAllocatedSize() const
+{
+	return Entries.GetAllocatedSize() + Cells.GetAllocatedSize() + EntryIndices.GetAllocatedSize() + CellArrayBytes;
+}
+
+void UPickUpProximitySubsystem::UpdateMemoryStat()
+{
+	SET_MEMORY_STAT(STAT_PickUpHashMemory, GetAllocatedSize());
+}
@@ -6,8 +6,14 @@
 #include "GameFramework/Actor.h"
 #include "Components/SphereComponent.h"
 #include "GameFramework/ProjectileMovementComponent.h"
+#include "MovementSnapshot.h"
+#include "MovementTimerSubsystem.h"
 #include "Grapple.generated.h"
 
+class AGrapple;
+// called when the hook stops being used, the actor is kept to be launched again
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnGrappleReleased, AGrapple*);
+
 UCLASS()
 class MOVEMENTMECHANICS_API AGrapple : public AActor
 {
@@ -40,13 +46,32 @@ protected:
 
 	FVector Velocity;
 	FVector StartLocation;
+	bool bLaunched = false;
+
+	// released when it has flown MaxDistance, the time of flight is scheduled instead of checking the distance every tick
+	FMovementTimerHandle ExpiryTimer;
+	void ScheduleExpiry(float Distance, const FVector& FlightVelocity);
+	void CancelExpiry();
+	UFUNCTION()
+		void OnHookStopped(const FHitResult& ImpactResult);
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	void SetVelocity(FVector);
 	void SetMaxDistance(float);
 
+	// moves the hook to Location and fires it, used instead of spawning a new hook for every shot
+	void Launch(const FVector& Location, const FVector& LaunchVelocity);
+	// hides the hook and stops it, broadcasts OnReleased
+	void Release();
+	bool IsLaunched() const { return bLaunched; };
+
+	// only the hook fields of the snapshot, nothing is broadcast on restore
+	void SaveSnapshot(FGrappleSnapshot& Snapshot) const;
+	void RestoreSnapshot(const FGrappleSnapshot& Snapshot);
+
+	FOnGrappleReleased OnReleased;
+
 	USphereComponent* GetCollisionComponent();
 	UStaticMeshComponent* GetMeshComponent() {	return HookMeshComponent;};
 
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "GrappleRewindComponent.generated.h"
+
+// Add to moving actors the grapple can attach to, so the server can validate grapple shots against their past transforms
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class MOVEMENTMECHANICS_API UGrappleRewindComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UGrappleRewindComponent();
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+};
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GrappleRewindSubsystem.generated.h"
+
+// grapple shots validated since they were last consumed, for the network soak
+struct FGrappleValidationStats
+{
+	int32 Confirmed = 0;
+	int32 Rejected = 0;
+	// seconds spent validating, summed and largest
+	double ValidationTime = 0.0;
+	double MaxValidationTime = 0.0;
+	// seconds between the client's time stamp and the server's time, summed
+	double RewindTime = 0.0;
+
+	int32 Num() const { return Confirmed + Rejected; };
+};
+
+/**
+ * Server side history of the transforms of moving actors the grapple can attach to.
+ * Transforms are stored per frame in fixed size arrays (one array per field, indexed by
+ * frame * MaxActors + slot), allocated once so recording does no allocation.
+ * Used to check a client's grapple shot against where the actors were when the client fired.
+ * Created in every game world, it only records once play begins on a server.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UGrappleRewindSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// number of frames kept, 64 frames is about one second at 60 hz
+	static constexpr int32 NumFrames = 64;
+	// max number of actors tracked at the same time
+	static constexpr int32 MaxActors = 128;
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	// the net mode is only known once play begins, clients never record
+	bool IsRecording() const { return bRecording; };
+	SIZE_T GetAllocatedSize() const;
+
+	// returns false when every slot is used or the world doesn't record
+	bool RegisterActor(AActor* Actor);
+	void UnregisterActor(AActor* Actor);
+
+	// traces from Start to End as the world was at Timestamp (server world time)
+	// the static world is traced once, the tracked actors are tested against their rewound bounds
+	bool RewindTrace(const FVector& Start, const FVector& End, float Timestamp, const AActor* IgnoreActor, ECollisionChannel Channel, FHitResult& OutHit);
+
+	void RecordValidation(bool bConfirmed, double ValidationSeconds, float RewindSeconds);
+	// returns the validations since the last call and starts counting again
+	FGrappleValidationStats ConsumeValidationStats();
+
+protected:
+	// finds the two recorded frames around Timestamp and the blend between them
+	bool FindFrames(float Timestamp, int32& OutOlder, int32& OutNewer, float& OutAlpha) const;
+
+	bool bRecording = false;
+	// newest frame written, -1 before the first record
+	int32 HeadFrame = -1;
+	int32 RecordedFrames = 0;
+
+	TArray<float> FrameTimes;
+	TArray<FVector> Locations;
+	TArray<FQuat> Rotations;
+
+	// per slot data, set when the actor is registered
+	TArray<TWeakObjectPtr<AActor>> Actors;
+	TArray<FBox> LocalBounds;
+	TArray<FVector> Scales;
+	TArray<AActor*> IgnoredActors;
+
+	FGrappleValidationStats ValidationStats;
+};
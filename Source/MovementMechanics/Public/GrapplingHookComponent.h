@@ -6,6 +6,7 @@
 
 #include "Grapple.h"
 #include "GrappleCable.h"
+#include "MovementTuningCurve.h"
 #include "Components/ActorComponent.h"
 #include "GrapplingHookComponent.generated.h"
 
@@ -17,6 +18,10 @@ enum UGrappleState
 	ATTACHED   UMETA(DisplayName = "ATTACHED"),
 };
 
+// called when the grapple changes state, only on transitions
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGrappleStateChanged, TEnumAsByte<UGrappleState>, NewState);
+// called when the player detaches the grapple, the cooldown starts from here
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnGrappleDetached);
 
 
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
@@ -32,11 +37,26 @@ public:
 		float GrappleSpeed = 7500.0f;
 	UPROPERTY(EditAnywhere)
 		float PullInitialSpeed = 1500.0f;
+	// a force, the movement component scales it by the frame time, the name is kept for existing assets
 	UPROPERTY(EditAnywhere)
 		float PerTickPulForce = 100000.0f;
+	// multiplier of PerTickPulForce over the seconds since the hook attached, constant when not set
+	// baked into a lookup table when play begins
+	UPROPERTY(EditAnywhere)
+		UCurveFloat* PullForceCurve = nullptr;
 	UPROPERTY(EditAnywhere)
 		float DisconnectDistance = 250.0f;
 
+	// max number of corners the cable can wrap around
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "0", ClampMax = "8"))
+		int32 MaxWrapPoints = 8;
+	// traces used to find the corner when the cable hits something
+	UPROPERTY(EditAnywhere)
+		int32 WrapSearchIterations = 4;
+	// distance kept between a wrap point and the surface it wraps around
+	UPROPERTY(EditAnywhere)
+		float WrapSurfaceOffset = 5.0f;
+
 
 	
 	// Use TSubclassOf to determine the base type of the Actor you want to spawn.
@@ -51,13 +71,34 @@ public:
 		TSubclassOf<AGrappleCable> CableClass = AGrappleCable::StaticClass();
 	AGrappleCable* GrappleCable;
 
+	UPROPERTY(BlueprintAssignable, Category = "Grapple")
+		FOnGrappleStateChanged OnGrappleStateChanged;
+	UPROPERTY(BlueprintAssignable, Category = "Grapple")
+		FOnGrappleDetached OnGrappleDetached;
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
 	UGrappleState GrappleState = READY;
 	FVector InitialHookDirection2D;
-	float TimeSinceLastGrappleDetach = 1000.0f;
+	FBakedMovementCurve PullForceTable;
+	// world time the hook attached
+	float AttachTime = 0.0f;
+
+	// points the cable wraps around, from the hook towards the player
+	TArray<FVector, TInlineAllocator<8>> WrapPoints;
+	// normal of the plane the cable bent in at each wrap point
+	TArray<FVector, TInlineAllocator<8>> WrapPlaneNormals;
+	FVector LastOwnerLocation;
+
+	// finds new wrap points and removes the ones the cable unwound from
+	void UpdateWrapPoints();
+	// world time of the last detach, the time since is computed when asked instead of accumulated every tick
+	float LastGrappleDetachTime = -1000.0f;
+
+	// changes the state and notifies listeners, the component only ticks while attached
+	void SetGrappleState(UGrappleState NewState);
 public:	
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
@@ -69,16 +110,29 @@ public:
 	bool IsGrappleAttached();
 
 	void FireGrapple(FVector targetLocation, FVector localOffset);
+	// spawns the hook and the cable the first time they are needed
+	void SpawnGrappleActors(const FVector& Location);
 	void DetachGrapple();
 	// returns the location of the start of the grapple cable
 	FVector CableStartLocation(FVector localOffset);
+	// returns the point the cable pulls the player towards, the last wrap point or the hook
+	FVector GetCableAnchor();
+	// force the cable pulls the player with while attached, the curve applied
+	float GetPullForce() const;
 	// returns a direction vector from the player location to the grapple hook location
+	// (the last wrap point when the cable is wrapped)
 	FVector ToGrappleHook();
 	// returns a direction vector from the player location to the grapple hook location but in 2D (no Z)
 	// used to detach grapple if we sing past it
 	FVector ToGrappleHook2D();
 
-	float GetTimeSinceLastGrappleDetach() { return TimeSinceLastGrappleDetach; };
+	float GetTimeSinceLastGrappleDetach();
+	float GetLastGrappleDetachTime() { return LastGrappleDetachTime; };
+	UGrappleState GetGrappleState() { return GrappleState; };
+
+	// restoring doesn't broadcast any event, the state is put back as it was
+	void SaveSnapshot(FGrappleSnapshot& Snapshot) const;
+	void RestoreSnapshot(const FGrappleSnapshot& Snapshot);
 
 	
 private:
@@ -86,4 +140,5 @@ private:
 		void OnGrappleHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 	UFUNCTION()
 		void OnGrappleDestroyed(AActor* Act);
+	void OnGrappleReleased(AGrapple* Hook);
 };
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "HitscanTraceSubsystem.generated.h"
+
+// a shot waiting to be traced
+struct FHitscanShot
+{
+	FVector Start;
+	FVector End;
+	// impulse applied along the shot direction to physics objects that are hit
+	float Impulse;
+	TWeakObjectPtr<AActor> Instigator;
+};
+
+/**
+ * Collects the hitscan shots fired by every weapon during a frame and traces them together.
+ * Shots queued this frame are sent as async traces at the end of the frame and their hits are
+ * applied on the next tick, the same frame of latency as any async trace.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UHitscanTraceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void QueueShot(const FVector& Start, const FVector& End, float Impulse, AActor* Instigator);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// traces whose results were read by the last tick, hit or not
+	int32 GetLastResolvedCount() const { return LastResolvedCount; };
+
+protected:
+	// applies the hits of the traces sent last frame
+	void ResolvePendingTraces();
+	// sends every queued shot as an async trace
+	void SubmitQueuedShots();
+
+	ECollisionChannel TraceChannel = ECC_Visibility;
+
+	TArray<FHitscanShot> QueuedShots;
+	// shots sent last frame, same order as PendingHandles
+	TArray<FHitscanShot> PendingShots;
+	TArray<FTraceHandle> PendingHandles;
+	int32 LastResolvedCount = 0;
+};
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "MovementMechanicsCharacter.h"
+#include "GrapplingHookComponent.h"
+#include "MovementAnimInstance.generated.h"
+
+// movement state copied from the character once per frame for the anim graph
+USTRUCT(BlueprintType)
+struct FMovementAnimSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = Movement)
+	FVector Velocity = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = Movement)
+	float AimPitch = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = Movement)
+	bool bIsFalling = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = Movement)
+	bool bWallRunning = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = Movement)
+	TEnumAsByte<WallSideENUM> WallSide = LEFT;
+
+	UPROPERTY(BlueprintReadOnly, Category = Movement)
+	TEnumAsByte<UGrappleState> GrappleState = READY;
+};
+
+/**
+ * Base class for the character anim blueprints.
+ * The snapshot is read from the character on the game thread in NativeUpdateAnimation, the meshes tick
+ * after the movement component so it holds the movement of this frame. The anim graph only reads the copy
+ * made in NativeThreadSafeUpdateAnimation, so the update can run on a worker thread.
+ */
+UCLASS(Transient, Blueprintable)
+class MOVEMENTMECHANICS_API UMovementAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
+
+	UPROPERTY(BlueprintReadOnly, Category = Movement)
+	FMovementAnimSnapshot Movement;
+
+	UPROPERTY(BlueprintReadOnly, Category = Movement)
+	float GroundSpeed = 0.0f;
+
+	// roll towards the wall while wall running, negative when the wall is on the left
+	UPROPERTY(BlueprintReadOnly, Category = Movement)
+	float WallRunLean = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = Movement)
+	bool bGrappleAttached = false;
+
+	UPROPERTY(EditDefaultsOnly, Category = Movement)
+	float WallRunLeanAngle = 15.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = Movement)
+	float WallRunLeanSpeed = 8.0f;
+
+private:
+	FMovementAnimSnapshot PendingSnapshot;
+};
+
+/**
+ * Skeletal mesh used by the character, times the game thread part of the animation update.
+ * Not registered with the budget allocator by default, the character registers the meshes of
+ * the characters that are not locally controlled.
+ */
+UCLASS(ClassGroup = (Rendering), meta = (BlueprintSpawnableComponent))
+class MOVEMENTMECHANICS_API UMovementSkeletalMeshComponent : public USkeletalMeshComponentBudgeted
+{
+	GENERATED_BODY()
+
+public:
+	UMovementSkeletalMeshComponent(const FObjectInitializer& ObjectInitializer);
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+};
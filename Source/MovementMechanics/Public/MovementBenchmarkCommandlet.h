@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MovementMechanicsStats.h"
+#include "MovementMechanicsCharacter.h"
+#include "MovementBenchmarkCommandlet.generated.h"
+
+class AMovementMechanicsCharacter;
+class FJsonObject;
+
+/**
+ * Measures the game thread cost of the movement mechanics with an increasing number of scripted characters.
+ *
+ * UnrealEditor-Cmd MovementMechanics -run=MovementBenchmark -nullrhi -Output=Bench.json
+ *     [-Map=] [-Pawn=] [-Counts=1,16,64,256] [-Warmup=] [-Duration=] [-Timestep=]
+ *     [-Baseline=Previous.json -Threshold=0.1] [-CheckAllocations] [-Policy=Bot|Server] [-CourseSeed=] [-PickUps=]
+ *     [-CompareWallTraces]
+ *
+ * Writes mean and p99 microseconds per timer and character count. When a baseline is given the
+ * commandlet fails if any mean or p99 is more than Threshold (fraction) slower than the baseline.
+ * With -CheckAllocations the timers are not sampled, instead the heap allocations made inside them
+ * after the warm up are counted and the commandlet fails if there is any.
+ * -CourseSeed spawns a generated stress course in front of the characters, the course hash is written
+ * with the results so runs can be checked to have used the same course.
+ * -Policy forces the compiled movement tick the characters use, so the versions can be compared.
+ * InputLatencyFrames is the number of frames between a scripted input and the velocity change it
+ * causes, it fails the baseline check when its p99 grows by any frame.
+ * -PickUps scatters that many pick ups around the characters and runs each count once more with the
+ * proximity subsystem and once with the per pick up overlap spheres. Both write the frame time, the pick
+ * up pairs tested per frame (sphere tests of the hash, pick up bounds touching a capsule for the physics
+ * scene), the pick ups left in the physics scene and the memory used by spawning them.
+ * -CompareWallTraces runs each count once more with the cached wall plane and once tracing the wall every
+ * frame, and writes the traces and the length of each wall run for both.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMovementBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+	// mean and p99 of the samples, sorts them
+	static TSharedPtr<FJsonObject> MakeTimerResult(TArray<double>& Samples);
+
+protected:
+	// runs one character count and returns its results
+	TSharedPtr<FJsonObject> RunCase(UWorld* TemplateWorld, int32 CharacterCount);
+	// runs one character count among PickUps pick ups, with the proximity subsystem or the overlap spheres
+	TSharedPtr<FJsonObject> RunPickUpCase(UWorld* TemplateWorld, int32 CharacterCount, bool bUseProximitySubsystem);
+	// runs one character count with the cached wall plane or tracing the wall every frame
+	TSharedPtr<FJsonObject> RunWallRunCase(UWorld* TemplateWorld, int32 CharacterCount, bool bCacheWallPlane);
+	// spawns the stress course in front of the player start and returns its hash
+	uint32 SpawnCourse(UWorld* World, const FTransform& SpawnTransform);
+	// spawns the characters in a grid around the player start
+	void SpawnCharacters(UWorld* World, int32 CharacterCount, const FTransform& SpawnTransform, TArray<AMovementMechanicsCharacter*>& OutCharacters);
+	// the scripted loop every character follows: run forward, jump onto walls and grapple
+	void DriveCharacter(AMovementMechanicsCharacter* Character, int32 Index, float Time);
+	// returns the number of regressions found against the baseline
+	int32 CompareWithBaseline(const TSharedPtr<FJsonObject>& Results, const FString& BaselinePath);
+
+	FString MapName = TEXT("/Game/FirstPerson/Maps/FirstPersonMap");
+	FString PawnClassName = TEXT("/Game/FirstPerson/Blueprints/BP_FirstPersonCharacter.BP_FirstPersonCharacter_C");
+	TArray<int32> CharacterCounts = { 1, 16, 64, 256 };
+	float Timestep = 1.0f / 60.0f;
+	float WarmupTime = 2.0f;
+	float Duration = 10.0f;
+	float Threshold = 0.1f;
+	bool bCheckAllocations = false;
+	EMovementPolicy Policy = EMovementPolicy::Bot;
+	bool bUseCourse = false;
+	int32 CourseSeed = 0;
+	int32 AllocationFailures = 0;
+	int32 PickUps = 0;
+	bool bCompareWallTraces = false;
+	// distance between characters when they are spawned in a grid
+	float SpawnSpacing = 300.0f;
+};
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "MovementCollisionProxyGenerator.generated.h"
+
+/**
+ * Editor tool, place one in a level and use the buttons in its details panel.
+ * Copies the simple collision boxes, spheres and capsules of every static mesh actor using a mesh from
+ * MeshPaths into proxies that only block the WallRun and Grapple channels, and makes the mesh itself
+ * ignore those channels so the movement traces stop testing its collision.
+ * Meshes with convex collision keep answering the traces, a box around them would add invisible walls
+ * on ramps and curved pieces.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API AMovementCollisionProxyGenerator : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AMovementCollisionProxyGenerator();
+
+	// only meshes inside these content folders get a proxy
+	UPROPERTY(EditAnywhere, Category = "Collision Proxies")
+		TArray<FString> MeshPaths = { TEXT("/Game/LevelPrototyping/") };
+
+	// meshes smaller than this in every axis are treated as clutter and get no proxy, so the traces ignore them
+	UPROPERTY(EditAnywhere, Category = "Collision Proxies")
+		float MinProxySize = 50.0f;
+
+	UFUNCTION(CallInEditor, Category = "Collision Proxies")
+		void GenerateProxies();
+
+	UFUNCTION(CallInEditor, Category = "Collision Proxies")
+		void RemoveProxies();
+
+	// tag given to the generated components, and to the actors whose mesh collision was changed, so they can be found again
+	static const FName ProxyTag;
+};
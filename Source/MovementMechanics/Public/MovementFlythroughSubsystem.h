@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MovementFlythroughSubsystem.generated.h"
+
+class AMovementMechanicsCharacter;
+
+/**
+ * Scripted high speed fly through of a World Partition map, only created when the process was started
+ * with -MovementFlythrough=Output.json.
+ *
+ * UnrealEditor MovementMechanics /Game/Maps/OpenWorld -game -MovementFlythrough=Flythrough.json
+ *     [-FlythroughSpeed=7500] [-FlythroughLeg=60000] [-FlythroughLegs=4] [-FlythroughGrappleTime=5]
+ *     [-FlythroughGrapplePitch=-20] [-FlythroughHitchMs=50] [-NoPredictiveStreaming]
+ *
+ * The first player's character flies FlythroughLegs straight legs of FlythroughLeg cm, turning 90 degrees
+ * between them, then fires the grapple FlythroughGrapplePitch degrees below the route and lets the cable pull
+ * it for up to FlythroughGrappleTime seconds, so the anchor's streaming source and the raised priority while
+ * grappling are on the route too (0 skips the grapple leg). Every frame the cells around the character are checked: a frame where they are not
+ * activated yet is a stall frame, and a run of them is one stall. A frame longer than FlythroughHitchMs while
+ * packages are loading counts as a blocking load. -NoPredictiveStreaming turns the character's look ahead
+ * streaming sources off so both can be compared on the same route. The results are written as json and the
+ * game quits.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementFlythroughSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	bool StartFlythrough();
+	void SampleStreaming(float DeltaTime);
+	bool StartGrappleLeg();
+	void TickGrappleLeg(float DeltaTime);
+	void FinishFlythrough();
+
+	FString OutputPath;
+	float Speed = 7500.0f;
+	float LegLength = 60000.0f;
+	int32 Legs = 4;
+	float GrappleTime = 5.0f;
+	float GrapplePitch = -20.0f;
+	float HitchMs = 50.0f;
+	bool bPredictiveStreaming = true;
+
+	TWeakObjectPtr<AMovementMechanicsCharacter> Character;
+	bool bFinished = false;
+	int32 Leg = 0;
+	float LegDistance = 0.0f;
+	FVector Direction = FVector::ForwardVector;
+	bool bGrappleLeg = false;
+	float GrappleLegTime = 0.0f;
+
+	int32 Frames = 0;
+	int32 StallFrames = 0;
+	int32 Stalls = 0;
+	int32 BlockingLoads = 0;
+	float MaxFrameMs = 0.0f;
+	float StallSeconds = 0.0f;
+	bool bStalled = false;
+	int32 GrappleFrames = 0;
+	int32 GrappleSourceFrames = 0;
+	int32 GrappleStallFrames = 0;
+};
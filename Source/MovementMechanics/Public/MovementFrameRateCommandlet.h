@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MovementFrameRateCommandlet.generated.h"
+
+class AMovementMechanicsCharacter;
+
+/**
+ * Checks that the movement mechanics don't depend on the tick rate.
+ *
+ * UnrealEditor-Cmd MovementMechanics -run=MovementFrameRate -nullrhi [-Map=] [-Pawn=] [-Rates=20,30,60,120,240]
+ *     [-Reference=60] [-Duration=10] [-PositionTolerance=100] [-WallRunTolerance=0.1] [-AttachTolerance=50]
+ *
+ * The same scripted input, timed in seconds, is run at each fixed tick rate. The location every 0.1
+ * seconds, how long each wall run lasted and where each grapple attached are compared with the reference
+ * rate. Fails when any of them is further off than its tolerance (cm or seconds) or when the number of wall
+ * runs or grapples differs. Rates have to be multiples of 10 so the samples fall on the same times.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementFrameRateCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMovementFrameRateCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	struct FFrameRateRun
+	{
+		int32 Rate = 0;
+		// location every 0.1 seconds
+		TArray<FVector> Trajectory;
+		TArray<float> WallRunDurations;
+		TArray<FVector> AttachPoints;
+	};
+
+	bool Run(UWorld* TemplateWorld, int32 Rate, int32 WorldIndex, FFrameRateRun& OutRun);
+	// input on whole frames at the same times for every rate: jump every second, grapple every three
+	// seconds half way between two jumps, turn at 30 degrees per second
+	void DriveCharacter(AMovementMechanicsCharacter* Character, int32 Frame, int32 Rate);
+	// returns the number of differences beyond the tolerances
+	int32 Compare(const FFrameRateRun& Reference, const FFrameRateRun& Run) const;
+
+	FString MapName = TEXT("/Game/FirstPerson/Maps/FirstPersonMap");
+	FString PawnClassName = TEXT("/Game/FirstPerson/Blueprints/BP_FirstPersonCharacter.BP_FirstPersonCharacter_C");
+	TArray<int32> Rates = { 20, 30, 60, 120, 240 };
+	int32 ReferenceRate = 60;
+	float Duration = 10.0f;
+	float PositionTolerance = 100.0f;
+	float WallRunTolerance = 0.1f;
+	float AttachTolerance = 50.0f;
+};
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MovementHitscanCommandlet.generated.h"
+
+class FJsonObject;
+
+/**
+ * Measures how many hitscan shots the batched trace queue resolves per millisecond.
+ *
+ * UnrealEditor-Cmd MovementMechanics -run=MovementHitscan -nullrhi [-Map=] [-Batches=100,1000,10000]
+ *     [-Frames=300] [-Warmup=30] [-Range=10000] [-Timestep=] [-Output=Hitscan.json]
+ *
+ * For each batch size that many shots are queued every frame, from random points around the player start
+ * in random directions, and the world is ticked so the subsystem sends and resolves them. The frame time
+ * of the same world without shots is taken off, what is left is the cost of the traces. Logs (and writes
+ * with -Output) the frame mean and p99 microseconds and the traces per millisecond of each batch size.
+ * Fails when a batch doesn't resolve every shot it queued.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementHitscanCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMovementHitscanCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	// returns the results of one batch size, null when shots were not resolved
+	TSharedPtr<FJsonObject> RunBatch(UWorld* TemplateWorld, int32 BatchSize, int32 WorldIndex);
+
+	FString MapName = TEXT("/Game/FirstPerson/Maps/FirstPersonMap");
+	TArray<int32> BatchSizes = { 100, 1000, 10000 };
+	int32 Frames = 300;
+	int32 WarmupFrames = 30;
+	float Range = 10000.0f;
+	float Timestep = 1.0f / 60.0f;
+	// shots start inside a cube of this size around the player start
+	float SpreadSize = 2000.0f;
+};
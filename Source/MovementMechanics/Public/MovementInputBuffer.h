@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+// presses that are kept for a while when they can't act on the frame they were made
+enum class EBufferedInput : uint8
+{
+	Jump,
+	Grapple,
+	Count
+};
+
+/**
+ * Timestamped presses of the buffered actions.
+ * The input handlers push into a lock free ring (one producer, one consumer), the movement tick drains it
+ * into the latest pending press of each action. A pending press acts on the first frame it is allowed to,
+ * as long as that is within its window, and is consumed when it does. Times are world seconds.
+ */
+class MOVEMENTMECHANICS_API FMovementInputBuffer
+{
+public:
+	static constexpr uint32 Capacity = 16;
+
+	FMovementInputBuffer();
+
+	// producer, false when the ring is full and the press was dropped
+	bool Push(EBufferedInput Input, double Time);
+
+	// consumer, moves the pushed presses to the pending ones
+	void Drain();
+	// true when Input was pressed no more than Window seconds before Now and hasn't been consumed
+	bool IsPending(EBufferedInput Input, double Now, float Window) const;
+	void Consume(EBufferedInput Input);
+	void Reset();
+
+	// time of the pending press, negative when there is none, used by the movement snapshots
+	double GetPendingTime(EBufferedInput Input) const { return PendingTimes[(int32)Input]; };
+	void SetPendingTime(EBufferedInput Input, double Time) { PendingTimes[(int32)Input] = Time; };
+
+private:
+	struct FPress
+	{
+		double Time;
+		EBufferedInput Input;
+	};
+
+	FPress Presses[Capacity];
+	// written by the producer only
+	std::atomic<uint32> Head;
+	// written by the consumer only
+	std::atomic<uint32> Tail;
+
+	double PendingTimes[(int32)EBufferedInput::Count];
+};
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MovementInputBufferCommandlet.generated.h"
+
+class AMovementMechanicsCharacter;
+
+/**
+ * Checks the input buffer windows with scripted press time stamps, and that presses pushed from another
+ * thread all arrive while the buffer is drained.
+ * Then runs a scripted character through the buffer: jumps pressed just before it lands or touches a wall
+ * have to fire on the first frame it can jump, and a grapple pressed at the end of the cooldown on the
+ * first frame the cooldown is over.
+ *
+ * UnrealEditor-Cmd MovementMechanics -run=MovementInputBuffer -nullrhi [-Presses=100000] [-Map=] [-Pawn=]
+ *     [-Duration=20] [-Timestep=]
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementInputBufferCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMovementInputBufferCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	// returns the number of failed checks
+	int32 CheckWindows();
+	int32 CheckThreadedPushes();
+	int32 CheckCharacter();
+	int32 CheckBufferedJumps(UWorld* World, AMovementMechanicsCharacter* Character);
+	int32 CheckBufferedGrapple(UWorld* World, AMovementMechanicsCharacter* Character);
+	void TickWorld(UWorld* World);
+
+	int32 Presses = 100000;
+	FString MapName = TEXT("/Game/FirstPerson/Maps/FirstPersonMap");
+	FString PawnClassName = TEXT("/Game/FirstPerson/Blueprints/BP_FirstPersonCharacter.BP_FirstPersonCharacter_C");
+	float Duration = 20.0f;
+	float Timestep = 1.0f / 60.0f;
+};
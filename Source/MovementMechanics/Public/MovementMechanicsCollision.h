@@ -0,0 +1,14 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+
+// trace channels set up in DefaultEngine.ini
+// the movement traces only test geometry that responds to these, decorative meshes can ignore them
+#define ECC_WallRun ECC_GameTraceChannel2
+#define ECC_Grapple ECC_GameTraceChannel3
+
+// collision profile of the simplified proxies that only block the movement channels
+#define MOVEMENT_PROXY_PROFILE TEXT("MovementProxy")
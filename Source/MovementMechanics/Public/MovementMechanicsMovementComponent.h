@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "MovementSnapshot.h"
+#include "MovementMechanicsMovementComponent.generated.h"
+
+// what simulated proxies need to follow the wall run and the grapple between movement updates,
+// written by the server every tick and replicated to simulated proxies only
+USTRUCT()
+struct FMovementProxyState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		bool bGrappling = false;
+	UPROPERTY()
+		bool bWallRunning = false;
+	// point the cable pulls towards, the last wrap point or the hook
+	UPROPERTY()
+		FVector_NetQuantize Anchor = FVector::ZeroVector;
+	// pull force of the grapple this tick, the curve is already applied
+	UPROPERTY()
+		float PullForce = 0.0f;
+	UPROPERTY()
+		FVector_NetQuantizeNormal WallNormal = FVector::ZeroVector;
+	UPROPERTY()
+		float GravityScale = 1.0f;
+};
+
+/**
+ * Character movement used by AMovementMechanicsCharacter.
+ * Counts the client moves the server found in error so the network soak can report corrections.
+ * Simulated proxies extrapolate with the replicated grapple pull and wall plane instead of only their
+ * last velocity, so they follow swings and wall runs between movement updates.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementMechanicsMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+
+	// returns the corrections since the last call and starts counting again
+	int32 ConsumeServerCorrections();
+
+	void SaveSnapshot(FMovementComponentSnapshot& Snapshot) const;
+	void RestoreSnapshot(const FMovementComponentSnapshot& Snapshot);
+
+	// called on simulated proxies when the replicated state of the mechanics arrives
+	void SetProxyState(const FMovementProxyState& State);
+
+	// extrapolate simulated proxies with the grapple pull and the wall plane, off gives the engine's extrapolation
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (Networking)")
+		bool bExtrapolateProxyMechanics = true;
+
+	// NetworkSimulatedSmoothLocationTime while a simulated proxy grapples or wall runs, the extrapolation is
+	// close to the server there so the mesh can catch up faster than the default
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (Networking)")
+		float ProxyMechanicsSmoothLocationTime = 0.04f;
+
+protected:
+	virtual void SimulateMovement(float DeltaTime) override;
+	// changes the velocity the engine extrapolates with
+	void ExtrapolateProxyMechanics(float DeltaTime);
+
+	int32 ServerCorrections = 0;
+	FMovementProxyState ProxyState;
+	// NetworkSimulatedSmoothLocationTime outside the mechanics, negative until the first state arrives
+	float DefaultSmoothLocationTime = -1.0f;
+};
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "VisualLogger/VisualLogger.h"
+
+// visual logger category of the wall probes, grapple traces, hook hits and state transitions
+// the UE_VLOG macros are compiled out with the visual logger (shipping) and do nothing while it isn't recording
+MOVEMENTMECHANICS_API DECLARE_LOG_CATEGORY_EXTERN(LogMovementMechanics, Log, All);
+
+// low level memory tracker tags, see -llm / stat LLM
+LLM_DECLARE_TAG_API(MovementWallRun, MOVEMENTMECHANICS_API);
+LLM_DECLARE_TAG_API(MovementGrapple, MOVEMENTMECHANICS_API);
+LLM_DECLARE_TAG_API(MovementSubsystems, MOVEMENTMECHANICS_API);
+
+DECLARE_STATS_GROUP(TEXT("MovementMechanics"), STATGROUP_MovementMechanics, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Tick"), STAT_MovementCharacterTick, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Grapple TickComponent"), STAT_MovementGrappleTick, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ShootRayToWall"), STAT_MovementShootRayToWall, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateWallRun"), STAT_MovementUpdateWallRun, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("State WallRunning"), STAT_MovementStateWallRunning, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Grapple Spawn"), STAT_MovementGrappleSpawn, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Spawn"), STAT_MovementCharacterSpawn, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Anim Game Thread"), STAT_MovementAnimTick, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Last Input Latency Frames"), STAT_MovementInputLatencyFrames, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Timer Wheel"), STAT_MovementTimerWheel, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Timers Scheduled"), STAT_MovementTimersScheduled, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hitscan Resolve"), STAT_HitscanResolve, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hitscan Traces Per Frame"), STAT_HitscanTracesPerFrame, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PickUp Proximity"), STAT_PickUpProximity, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("PickUps Registered"), STAT_PickUpsRegistered, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("PickUp Proximity Tests"), STAT_PickUpProximityTests, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("PickUp Hash Memory"), STAT_PickUpHashMemory, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Grapple Rewind Trace"), STAT_GrappleRewindTrace, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Grapple Rewind Memory"), STAT_GrappleRewindMemory, STATGROUP_MovementMechanics, MOVEMENTMECHANICS_API);
+
+// timers that can be sampled per call by the benchmark commandlet
+enum class EMovementTimer : uint8
+{
+	CharacterTick,
+	GrappleTick,
+	ShootRayToWall,
+	UpdateWallRun,
+	GrappleSpawn,
+	CharacterSpawn,
+	AnimTick,
+	Count
+};
+
+// per call samples in microseconds, only stored while recording is enabled
+struct MOVEMENTMECHANICS_API FMovementTimings
+{
+	static bool bRecording;
+	static TArray<double> Samples[(int32)EMovementTimer::Count];
+	// frames between an input and the first velocity change it caused, see the latency probe on the character
+	static TArray<double> InputLatencyFrames;
+
+	static const TCHAR* GetName(EMovementTimer Timer);
+	static void Reset();
+};
+
+/**
+ * Counts the heap allocations made on the game thread inside the movement timer scopes.
+ * Install wraps GMalloc, so it is only done by the tools that check for allocations.
+ */
+struct MOVEMENTMECHANICS_API FMovementAllocationTracker
+{
+#if !UE_BUILD_SHIPPING
+	static void Install();
+	static bool IsInstalled();
+
+	static bool bEnabled;
+	static int32 Counts[(int32)EMovementTimer::Count];
+
+	// scopes currently open, an allocation counts for all of them
+	static constexpr int32 MaxDepth = 8;
+	static EMovementTimer Scopes[MaxDepth];
+	static int32 Depth;
+
+	static void Reset();
+	static void EnterScope(EMovementTimer Timer)
+	{
+		if (Depth < MaxDepth)
+			Scopes[Depth] = Timer;
+		Depth++;
+	}
+	static void LeaveScope()
+	{
+		Depth--;
+	}
+	static void CountAllocation();
+#endif
+};
+
+struct FScopedMovementTimer
+{
+	FScopedMovementTimer(EMovementTimer InTimer)
+		: Timer(InTimer)
+		, StartTime(FMovementTimings::bRecording ? FPlatformTime::Seconds() : 0.0)
+	{
+#if !UE_BUILD_SHIPPING
+		FMovementAllocationTracker::EnterScope(Timer);
+#endif
+	}
+
+	~FScopedMovementTimer()
+	{
+#if !UE_BUILD_SHIPPING
+		FMovementAllocationTracker::LeaveScope();
+#endif
+		if (FMovementTimings::bRecording)
+			FMovementTimings::Samples[(int32)Timer].Add((FPlatformTime::Seconds() - StartTime) * 1000000.0);
+	}
+
+	EMovementTimer Timer;
+	double StartTime;
+};
+
+// cycle stat for stat/insights plus a sample for the benchmark
+#define MOVEMENT_SCOPE_TIMER(Stat, Timer) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	FScopedMovementTimer ANONYMOUS_VARIABLE(MovementTimer)(Timer)
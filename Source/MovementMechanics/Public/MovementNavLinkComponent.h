@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NavLinkCustomComponent.h"
+#include "NavAreas/NavArea.h"
+#include "MovementNavLinkComponent.generated.h"
+
+// Mechanic a generated nav link needs to be crossed
+UENUM(BlueprintType)
+enum class EMovementTraversal : uint8
+{
+	WallRun    UMETA(DisplayName = "Wall Run"),
+	Grapple    UMETA(DisplayName = "Grapple"),
+};
+
+// nav areas of the generated links, the default cost makes bots prefer walking when it isn't much longer
+UCLASS(Config = Engine)
+class MOVEMENTMECHANICS_API UNavArea_WallRun : public UNavArea
+{
+	GENERATED_BODY()
+
+public:
+	UNavArea_WallRun();
+};
+
+UCLASS(Config = Engine)
+class MOVEMENTMECHANICS_API UNavArea_Grapple : public UNavArea
+{
+	GENERATED_BODY()
+
+public:
+	UNavArea_Grapple();
+};
+
+/**
+ * Nav link created by AMovementNavLinkGenerator.
+ * When a bot's path reaches the link the character is told to start the traversal,
+ * the path following keeps steering towards the end of the link.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementNavLinkComponent : public UNavLinkCustomComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement Link")
+		EMovementTraversal Traversal = EMovementTraversal::WallRun;
+
+	// estimated seconds to cross the link
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement Link")
+		float Cost = 0.0f;
+
+	// world location the grapple is aimed at, unused by wall run links
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement Link")
+		FVector Anchor = FVector::ZeroVector;
+
+	virtual bool OnLinkMoveStarted(UObject* PathComp, const FVector& DestPoint) override;
+};
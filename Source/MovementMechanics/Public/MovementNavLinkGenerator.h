@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "MovementNavLinkGenerator.generated.h"
+
+class AMovementMechanicsCharacter;
+
+/**
+ * Editor tool, place one in a level with a navmesh and use the buttons in its details panel.
+ * Scans every navmesh tile for walls that can be ran on and grapple anchors, using the same rules
+ * as the character (CanSurfaceBeWallRan, WallHeight, the hook's MaxDistance), and adds a
+ * UMovementNavLinkComponent for each traversal found so bots can path through them with plain
+ * navmesh queries. The tiles are scanned in parallel.
+ * The actor has to stay in the level, the links belong to it.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API AMovementNavLinkGenerator : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AMovementNavLinkGenerator();
+
+	// the movement rules are read from the defaults of this class
+	UPROPERTY(EditAnywhere, Category = "Nav Links")
+		TSubclassOf<AMovementMechanicsCharacter> CharacterClass;
+
+	UPROPERTY(EditAnywhere, Category = "Nav Links")
+		bool bWallRunLinks = true;
+
+	UPROPERTY(EditAnywhere, Category = "Nav Links")
+		bool bGrappleLinks = true;
+
+	// directions searched around the center of every navmesh polygon
+	UPROPERTY(EditAnywhere, Category = "Nav Links", meta = (ClampMin = "1", ClampMax = "32"))
+		int32 SearchDirections = 8;
+
+	// links shorter than this are left to the navmesh
+	UPROPERTY(EditAnywhere, Category = "Nav Links")
+		float MinLinkLength = 400.0f;
+
+	// how far below the end of a traversal the navmesh is searched for a landing
+	UPROPERTY(EditAnywhere, Category = "Nav Links")
+		float LandingSearchHeight = 600.0f;
+
+	// links kept per polygon, the cheapest ones
+	UPROPERTY(EditAnywhere, Category = "Nav Links", meta = (ClampMin = "1"))
+		int32 MaxLinksPerPolygon = 4;
+
+	// wall run
+	// how far from the jump a wall is looked for
+	UPROPERTY(EditAnywhere, Category = "Nav Links|Wall Run")
+		float WallSearchDistance = 400.0f;
+
+	// distance between the wall checks along the run
+	UPROPERTY(EditAnywhere, Category = "Nav Links|Wall Run")
+		float WallRunStep = 100.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Nav Links|Wall Run")
+		float MaxWallRunLength = 3000.0f;
+
+	// grapple
+	// pitch of the aim directions tried from each polygon, in degrees
+	UPROPERTY(EditAnywhere, Category = "Nav Links|Grapple")
+		TArray<float> GrapplePitches = { 25.0f, 45.0f, 65.0f };
+
+	UFUNCTION(CallInEditor, Category = "Nav Links")
+		void GenerateLinks();
+
+	UFUNCTION(CallInEditor, Category = "Nav Links")
+		void RemoveLinks();
+
+	// tag given to the generated components so they can be found again
+	static const FName LinkTag;
+};
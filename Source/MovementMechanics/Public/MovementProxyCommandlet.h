@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "Engine/EngineTypes.h"
+#include "MovementMechanicsMovementComponent.h"
+#include "MovementProxyCommandlet.generated.h"
+
+class AMovementMechanicsCharacter;
+class FJsonObject;
+
+/**
+ * Measures how far simulated proxies are from the server while the scripted character wall runs and grapples.
+ *
+ * UnrealEditor-Cmd MovementMechanics -run=MovementProxy -nullrhi [-Map=] [-Pawn=] [-Timestep=]
+ *     [-Rates=5,10,20,30,60] [-LatencyMs=50] [-Duration=20] [-Output=Proxy.json]
+ *
+ * The server character and its proxy run in the same world. The proxy gets the replicated movement and
+ * mechanics state Rates times a second, LatencyMs late, the way a client would. Every frame the distance
+ * between the proxy and the server character is sampled. Each rate runs once with the engine's extrapolation
+ * and once with the mechanics extrapolation, the mean and p99 error in cm of both are logged and written.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementProxyCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMovementProxyCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	// one net update on its way to the proxy
+	struct FProxyUpdate
+	{
+		float DeliveryTime;
+		FRepMovement Movement;
+		uint8 MovementMode;
+		FMovementProxyState State;
+	};
+
+	// runs one update rate and returns the error of the proxy, null when the characters could not be spawned
+	TSharedPtr<FJsonObject> RunCase(UWorld* TemplateWorld, float UpdateRate, bool bExtrapolate, int32 WorldIndex);
+	void DeliverUpdate(AMovementMechanicsCharacter* Proxy, const FProxyUpdate& Update);
+	// same loop as the rollback check: run forward, jump every second, grapple every three seconds
+	void DriveCharacter(AMovementMechanicsCharacter* Character, int32 Frame);
+
+	FString MapName = TEXT("/Game/FirstPerson/Maps/FirstPersonMap");
+	FString PawnClassName = TEXT("/Game/FirstPerson/Blueprints/BP_FirstPersonCharacter.BP_FirstPersonCharacter_C");
+	TArray<float> UpdateRates = { 5.0f, 10.0f, 20.0f, 30.0f, 60.0f };
+	float Timestep = 1.0f / 60.0f;
+	float LatencyMs = 50.0f;
+	float Duration = 20.0f;
+};
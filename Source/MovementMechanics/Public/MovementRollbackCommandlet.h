@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MovementRollbackCommandlet.generated.h"
+
+class AMovementMechanicsCharacter;
+
+/**
+ * Checks that restoring a movement snapshot and running the same input again gives the same trajectory.
+ * At each check point the character state is saved, Frames frames are run and recorded, the state is
+ * restored and the same frames are run again. Fails when any location or velocity differs in any bit.
+ *
+ * UnrealEditor-Cmd MovementMechanics -run=MovementRollback -nullrhi [-Map=] [-Pawn=] [-Timestep=]
+ *     [-Checks=8] [-Spacing=47] [-Frames=120]
+ *
+ * Only the character is rolled back, so use a map where it doesn't push simulated physics objects.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementRollbackCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMovementRollbackCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	// runs Count frames from Frame and records the location and velocity after each one
+	void RunFrames(UWorld* World, AMovementMechanicsCharacter* Character, int32 Frame, int32 Count, TArray<FVector>& OutTrajectory);
+	// scripted input for a frame, depends only on the frame number so a rerun gets the same input
+	void DriveCharacter(AMovementMechanicsCharacter* Character, int32 Frame);
+
+	FString MapName = TEXT("/Game/FirstPerson/Maps/FirstPersonMap");
+	FString PawnClassName = TEXT("/Game/FirstPerson/Blueprints/BP_FirstPersonCharacter.BP_FirstPersonCharacter_C");
+	float Timestep = 1.0f / 60.0f;
+	int32 Checks = 8;
+	// frames between check points, not a multiple of the jump and grapple periods so the
+	// checks start in different states
+	int32 Spacing = 47;
+	int32 Frames = 120;
+};
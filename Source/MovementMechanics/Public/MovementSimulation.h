@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AMovementMechanicsCharacter;
+
+// helpers shared by the commandlets that run the movement mechanics headless
+namespace MovementSimulation
+{
+	// loads the map package and returns its world, used as the template for simulation worlds
+	MOVEMENTMECHANICS_API UWorld* LoadTemplateWorld(const FString& MapName);
+
+	// duplicates the template into a new game world, initialises it and begins play
+	MOVEMENTMECHANICS_API UWorld* CreateWorld(UWorld* TemplateWorld, int32 Index);
+	MOVEMENTMECHANICS_API void DestroyWorld(UWorld* World);
+
+	// transform of the first player start in the world, identity if there is none
+	MOVEMENTMECHANICS_API FTransform FindSpawnTransform(UWorld* World);
+
+	// spawns a character without a controller, the class falls back to AMovementMechanicsCharacter
+	MOVEMENTMECHANICS_API AMovementMechanicsCharacter* SpawnCharacter(UWorld* World, const FString& PawnClassName, const FTransform& SpawnTransform);
+
+	// spawns a character possessed by an ai controller so scripted input is consumed
+	MOVEMENTMECHANICS_API AMovementMechanicsCharacter* SpawnScriptedCharacter(UWorld* World, const FString& PawnClassName, const FTransform& SpawnTransform);
+}
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <type_traits>
+
+// Plain copies of the movement mechanic state, saved and restored by AMovementMechanicsCharacter.
+// They only hold values, so a rollback buffer can copy them with memcpy.
+// World times are stored relative to the world time at save, so a snapshot can be restored later.
+
+// fields of the character movement component changed by the wall run and the grapple
+struct FMovementComponentSnapshot
+{
+	FVector Velocity;
+	FVector PendingForce;
+	FVector PendingImpulse;
+	FVector PendingLaunchVelocity;
+	FVector PlaneConstraintNormal;
+	float GravityScale;
+	float GroundFriction;
+	float AirControl;
+	float MaxWalkSpeed;
+	uint8 MovementMode;
+	uint8 CustomMovementMode;
+	bool bConstrainToPlane;
+};
+
+// grapple component, hook and cable wrap
+struct FGrappleSnapshot
+{
+	static constexpr int32 MaxWrapPoints = 8;
+
+	uint8 State;
+	FVector InitialHookDirection2D;
+	// LastGrappleDetachTime minus the world time
+	float DetachTimeOffset;
+	// AttachTime minus the world time
+	float AttachTimeOffset;
+	FVector LastOwnerLocation;
+	int32 NumWrapPoints;
+	FVector WrapPoints[MaxWrapPoints];
+	FVector WrapPlaneNormals[MaxWrapPoints];
+
+	bool bHookLaunched;
+	// false once the hook stopped on what it hit
+	bool bHookMoving;
+	FVector HookLocation;
+	FVector HookVelocity;
+	FVector HookStartLocation;
+};
+
+struct FMovementSnapshot
+{
+	FVector Location;
+	FQuat Rotation;
+	FRotator ControlRotation;
+
+	// jump
+	int32 JumpCurrentCount;
+	int32 JumpCurrentCountPreJump;
+	float JumpKeyHoldTime;
+	float JumpForceTimeRemaining;
+	bool bPressedJump;
+	bool bWasJumping;
+
+	// input
+	float ForwardAxis;
+	float RightAxis;
+	float ScriptedForwardAxis;
+	float ScriptedRightAxis;
+
+	// EMovementState
+	uint8 MovementState;
+
+	// wall run
+	uint8 WallSide;
+	FVector WallRunDirection;
+	float NormalGravity;
+	FVector CachedWallNormal;
+	FVector CachedWallPoint;
+	FVector PredictedWallExit;
+	bool bWallEdgePredicted;
+	float TimeSinceWallValidation;
+	// WallRunStartTime minus the world time
+	float WallRunStartOffset;
+
+	// WallRunEndTime minus the world time
+	float WallRunEndOffset;
+
+	// GrappleCooldownEndTime minus the world time
+	float GrappleCooldownOffset;
+
+	// pending buffered presses, one per EBufferedInput, press time minus the world time
+	static constexpr int32 NumBufferedInputs = 2;
+	float BufferedInputOffsets[NumBufferedInputs];
+	bool bBufferedInputPending[NumBufferedInputs];
+
+	FMovementComponentSnapshot Movement;
+	FGrappleSnapshot Grapple;
+};
+
+static_assert(std::is_trivially_copyable_v<FMovementSnapshot>, "movement snapshots are copied with memcpy");
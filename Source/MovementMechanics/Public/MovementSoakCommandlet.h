@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MovementSoakCommandlet.generated.h"
+
+/**
+ * Starts a local dedicated server and Clients headless clients running the scripted wall run and
+ * grapple loop with packet emulation, and waits for the server to write its csv.
+ *
+ * UnrealEditor-Cmd MovementMechanics -run=MovementSoak -Output=Soak.csv [-Clients=4] [-Duration=120]
+ *     [-Map=] [-Port=7777] [-PktLag=100] [-PktLagVariance=20] [-PktLoss=2] [-Interval=1]
+ *
+ * The packet emulation is applied on the server and on every client, so the round trip is twice PktLag.
+ * Csv columns: Time, Connection, FrameTimeMs, MaxFrameTimeMs, Corrections, InBytesPerSecond,
+ * OutBytesPerSecond, PingMs, InPacketsLost, OutPacketsLost, one row per connection and interval.
+ * The grapple rewind columns are for all connections: GrappleValidations, GrappleRejections,
+ * ValidationMeanUs, ValidationMaxUs, RewindMeanMs (how far back the shots were validated) and
+ * RewindMemoryBytes. -Clients=2 is the two client measurement of the rewind.
+ * See UMovementSoakSubsystem for the game side.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementSoakCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMovementSoakCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	FProcHandle Launch(const FString& Arguments, const FString& LogName);
+
+	FString MapName = TEXT("/Game/FirstPerson/Maps/FirstPersonMap");
+	int32 ClientCount = 4;
+	float Duration = 120.0f;
+	float Interval = 1.0f;
+	int32 Port = 7777;
+	int32 PktLag = 100;
+	int32 PktLagVariance = 20;
+	int32 PktLoss = 2;
+	// how long past the duration the server may take before it is killed
+	float Timeout = 120.0f;
+};
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MovementSoakSubsystem.generated.h"
+
+class AMovementMechanicsCharacter;
+
+// one sample of one client connection, written as a csv row by the server
+struct FMovementSoakSample
+{
+	float Time = 0.0f;
+	int32 Connection = 0;
+	float FrameTimeMs = 0.0f;
+	float MaxFrameTimeMs = 0.0f;
+	int32 Corrections = 0;
+	int32 InBytesPerSecond = 0;
+	int32 OutBytesPerSecond = 0;
+	float PingMs = 0.0f;
+	int32 InPacketsLost = 0;
+	int32 OutPacketsLost = 0;
+	// grapple shots of all connections validated by rewinding, and the memory of the rewind history
+	int32 GrappleValidations = 0;
+	int32 GrappleRejections = 0;
+	float ValidationMeanUs = 0.0f;
+	float ValidationMaxUs = 0.0f;
+	float RewindMeanMs = 0.0f;
+	int32 RewindMemoryBytes = 0;
+};
+
+/**
+ * Game side of the network soak, only created when the process was started with -MovementSoak=.
+ * Clients (-MovementSoak=Client) run the scripted wall run and grapple loop on their own character.
+ * The dedicated server (-MovementSoak=Server) samples every connection once per SampleInterval and
+ * writes the csv to -SoakOutput= once -SoakDuration= seconds have passed since the first client joined.
+ * Both quit when the soak is over. Started by UMovementSoakCommandlet.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementSoakSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	void TickClient(float DeltaTime);
+	void TickServer(float DeltaTime);
+	void SampleConnections();
+	bool WriteResults() const;
+
+	bool bServer = false;
+	// seconds since the soak started, negative until it has
+	float SoakTime = -1.0f;
+	float Duration = 120.0f;
+	float SampleInterval = 1.0f;
+	FString OutputPath;
+
+	// client
+	int32 ClientIndex = 0;
+	TWeakObjectPtr<AMovementMechanicsCharacter> Character;
+
+	// server, frame times since the last sample
+	float NextSampleTime = 0.0f;
+	double FrameTimeSum = 0.0;
+	float MaxFrameTime = 0.0f;
+	int32 FrameCount = 0;
+	TArray<FMovementSoakSample> Samples;
+};
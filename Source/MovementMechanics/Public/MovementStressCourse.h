@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "MovementStressCourse.generated.h"
+
+class UHierarchicalInstancedStaticMeshComponent;
+class UStaticMesh;
+
+/**
+ * Seeded course of wall-runnable walls and grapple anchors for performance testing.
+ * Everything is instanced, so a course with thousands of walls is a few components and draw calls.
+ * The same seed and settings always give the same course, GetCourseHash can be used to check it.
+ * Place one in a level and use Generate in its details panel, or let the benchmark commandlet spawn one.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API AMovementStressCourse : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AMovementStressCourse();
+
+	virtual void BeginPlay() override;
+
+	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Stress Course")
+		void Generate();
+
+	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Stress Course")
+		void Clear();
+
+	// crc of every generated instance transform
+	uint32 GetCourseHash() const { return CourseHash; };
+	int32 GetWallCount() const;
+	int32 GetAnchorCount() const;
+
+	UPROPERTY(VisibleAnywhere, Category = "Stress Course")
+		UHierarchicalInstancedStaticMeshComponent* Walls;
+
+	UPROPERTY(VisibleAnywhere, Category = "Stress Course")
+		UHierarchicalInstancedStaticMeshComponent* Anchors;
+
+	UPROPERTY(EditAnywhere, Category = "Stress Course")
+		int32 Seed = 1;
+
+	// regenerate when play starts instead of using the saved instances
+	UPROPERTY(EditAnywhere, Category = "Stress Course")
+		bool bGenerateOnBeginPlay = false;
+
+	// size of the course, it runs along the actor's forward vector
+	UPROPERTY(EditAnywhere, Category = "Stress Course")
+		float CourseLength = 50000.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Stress Course")
+		float CourseWidth = 10000.0f;
+
+	// nothing is placed this close to the start so characters can spawn there
+	UPROPERTY(EditAnywhere, Category = "Stress Course")
+		float StartClearance = 1500.0f;
+
+	// walls
+	// the course is split into lanes and cells, each cell gets a wall with this chance
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Walls", meta = (ClampMin = "0", ClampMax = "1"))
+		float WallDensity = 0.5f;
+
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Walls")
+		float LaneSpacing = 600.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Walls")
+		float CellLength = 800.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Walls")
+		float MinWallHeight = 300.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Walls")
+		float MaxWallHeight = 900.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Walls")
+		float MinWallLength = 400.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Walls")
+		float MaxWallLength = 1200.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Walls")
+		float WallThickness = 50.0f;
+
+	// random yaw added to each wall
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Walls")
+		float MaxWallYaw = 15.0f;
+
+	// anchors
+	// anchors are placed on a grid with this spacing
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Anchors")
+		float AnchorSpacing = 1500.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Anchors")
+		float AnchorHeight = 1200.0f;
+
+	// random offset in every axis
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Anchors")
+		float AnchorJitter = 300.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Stress Course|Anchors")
+		float AnchorSize = 100.0f;
+
+protected:
+	// transform that scales and places Mesh so its bounds fill a box of Size centered on Center
+	static FTransform FitMeshToBox(const UStaticMesh* Mesh, const FVector& Center, const FVector& Size, const FRotator& Rotation);
+
+	UPROPERTY(VisibleAnywhere, Category = "Stress Course")
+		uint32 CourseHash = 0;
+};
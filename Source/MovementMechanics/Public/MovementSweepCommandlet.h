@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MovementSweepCommandlet.generated.h"
+
+class AMovementMechanicsCharacter;
+
+// one set of tuning values tested by the sweep
+struct FMovementSweepParams
+{
+	float GrappleSpeed = 7500.0f;
+	float PullInitialSpeed = 1500.0f;
+	float PerTickPulForce = 100000.0f;
+	float WalkingSpeed = 1100.0f;
+	float GravityScale = 0.6f;
+	float WallHeight = 200.0f;
+};
+
+// scripted input event, applied when the simulation time reaches Time
+struct FMovementSweepEvent
+{
+	float Time = 0.0f;
+	FName Action;
+	float Value = 0.0f;
+};
+
+// results of one simulated run
+struct FMovementSweepResult
+{
+	// -1 when the goal was never reached
+	float CompletionTime = -1.0f;
+	float DistanceTravelled = 0.0f;
+	float MaxSpeed = 0.0f;
+	float WallRunTime = 0.0f;
+	float GrappleTime = 0.0f;
+	FVector FinalLocation = FVector::ZeroVector;
+};
+
+/**
+ * Runs the movement mechanics headless under many parameter sets and writes the results as CSV.
+ *
+ * UnrealEditor-Cmd MovementMechanics -run=MovementSweep -nullrhi -Params=Sweep.csv -Script=Course.txt
+ *     -Output=Results.csv -Goal=X,Y,Z [-Map=] [-Pawn=] [-Timestep=] [-MaxTime=] [-Worlds=] [-ShardCount=]
+ *
+ * Params csv: GrappleSpeed,PullInitialSpeed,PerTickPulForce,WalkingSpeed,GravityScale,WallHeight per line.
+ * Script: "Time Action Value" per line, actions are Forward, Right, Jump and Grapple.
+ * Worlds can only be ticked from the game thread, so the sweep starts ShardCount processes of itself
+ * (one per core by default), each runs every ShardCount-th parameter set with -Shard= and writes its own
+ * csv, and the rows are merged into Output in parameter order once they all finished.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementSweepCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMovementSweepCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	// runs the parameter sets of one shard in this process and writes their csv
+	int32 RunShard(const TArray<FMovementSweepParams>& SweepParams, const TArray<FMovementSweepEvent>& Script, int32 Shard, int32 ShardCount, const FString& OutputPath);
+	// starts one process per shard, waits for them and merges their csv into OutputPath
+	int32 RunShards(int32 ShardCount, const FString& OutputPath);
+	FString GetShardOutputPath(const FString& OutputPath, int32 Shard) const;
+
+	bool LoadParams(const FString& Path, TArray<FMovementSweepParams>& OutParams);
+	bool LoadScript(const FString& Path, TArray<FMovementSweepEvent>& OutScript);
+
+	AMovementMechanicsCharacter* SpawnCharacter(UWorld* World, const FMovementSweepParams& SweepParams);
+	void ApplyEvent(AMovementMechanicsCharacter* Character, const FMovementSweepEvent& Event);
+
+	FString MapName = TEXT("/Game/FirstPerson/Maps/FirstPersonMap");
+	FString PawnClassName = TEXT("/Game/FirstPerson/Blueprints/BP_FirstPersonCharacter.BP_FirstPersonCharacter_C");
+	// fixed simulation step, the worlds are stepped as fast as the cpu allows
+	float Timestep = 1.0f / 60.0f;
+	float MaxTime = 60.0f;
+	// how many worlds are alive and stepped together
+	int32 WorldsPerBatch = 16;
+	FVector Goal = FVector::ZeroVector;
+	float GoalRadius = 200.0f;
+	// full paths, passed on to the shard processes
+	FString ParamsPath;
+	FString ScriptPath;
+};
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MovementTimerSubsystem.h"
+#include "MovementTimerBenchmarkCommandlet.generated.h"
+
+/**
+ * Compares the timer wheel with expiry checked by ticking every object.
+ *
+ * UnrealEditor-Cmd MovementMechanics -run=MovementTimerBenchmark [-Timers=10000] [-Frames=3600] [-Timestep=]
+ *     [-CancelsPerFrame=100] [-MinDelay=0.5] [-MaxDelay=10] [-Output=Timers.json]
+ *
+ * Both keep Timers timers running with random delays, a timer starts again when it expires, and
+ * CancelsPerFrame random timers are cancelled and started again every frame. Logs (and writes with
+ * -Output) the mean and p99 microseconds per frame of both.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementTimerBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMovementTimerBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	void RunWheel(TArray<double>& OutFrameSamples);
+	void RunTicked(TArray<double>& OutFrameSamples);
+	void OnWheelTimer(int32 Index);
+
+	int32 Timers = 10000;
+	int32 Frames = 3600;
+	float Timestep = 1.0f / 60.0f;
+	int32 CancelsPerFrame = 100;
+	float MinDelay = 0.5f;
+	float MaxDelay = 10.0f;
+	int32 Seed = 1;
+
+	TArray<float> Delays;
+	FMovementTimerWheel Wheel;
+	TArray<FMovementTimerHandle> Handles;
+	int32 Expired = 0;
+};
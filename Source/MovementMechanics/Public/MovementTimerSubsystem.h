@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MovementTimerSubsystem.generated.h"
+
+// Timer scheduled on a FMovementTimerWheel, no longer scheduled once it fired or was cancelled
+struct FMovementTimerHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; };
+	void Invalidate() { Index = INDEX_NONE; };
+};
+
+/**
+ * What a timer calls when it fires, a member function of a UObject held weakly with an optional int payload.
+ * Built without allocating, unlike binding a delegate, so timers can be scheduled every frame.
+ */
+struct FMovementTimerCallback
+{
+	FWeakObjectPtr Object;
+	void (*Function)(UObject*, int32) = nullptr;
+	int32 Payload = 0;
+
+	template<typename UserClass, void (UserClass::*Method)()>
+	static FMovementTimerCallback Create(UserClass* InObject)
+	{
+		FMovementTimerCallback callback;
+		callback.Object = InObject;
+		callback.Function = [](UObject* Target, int32) { (static_cast<UserClass*>(Target)->*Method)(); };
+		return callback;
+	}
+
+	template<typename UserClass, void (UserClass::*Method)(int32)>
+	static FMovementTimerCallback Create(UserClass* InObject, int32 InPayload)
+	{
+		FMovementTimerCallback callback;
+		callback.Object = InObject;
+		callback.Function = [](UObject* Target, int32 Value) { (static_cast<UserClass*>(Target)->*Method)(Value); };
+		callback.Payload = InPayload;
+		return callback;
+	}
+
+	// does nothing once the object is gone
+	void ExecuteIfValid() const
+	{
+		if (UObject* target = Object.Get())
+			Function(target, Payload);
+	}
+};
+
+/**
+ * Hierarchical timer wheel, a root wheel of 256 ticks and three coarser wheels of 64 slots each.
+ * Timers are kept in intrusive lists per slot, so scheduling and cancelling are O(1) whatever the
+ * number of timers, and advancing only visits the slot of the current tick. When the root wheel
+ * wraps the next slot of the coarser wheel is spread over it.
+ * Timers fire in batches, the callbacks of a tick are run after the wheel has been updated so they
+ * can schedule and cancel timers.
+ */
+class MOVEMENTMECHANICS_API FMovementTimerWheel
+{
+public:
+	// timers fire on the first tick at or after their time
+	static constexpr float TickSeconds = 1.0f / 64.0f;
+
+	FMovementTimerWheel();
+
+	FMovementTimerHandle Schedule(float Delay, const FMovementTimerCallback& Callback);
+	// does nothing if the timer already fired, always invalidates the handle
+	bool Cancel(FMovementTimerHandle& Handle);
+	bool IsScheduled(const FMovementTimerHandle& Handle) const;
+
+	// returns the number of timers fired
+	int32 Advance(float DeltaSeconds);
+	int32 Num() const { return NumScheduled; };
+	void Reset();
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	static constexpr int32 Levels = 4;
+	static constexpr int32 RootBits = 8;
+	static constexpr int32 LevelBits = 6;
+	static constexpr int32 RootSlots = 1 << RootBits;
+	static constexpr int32 LevelSlots = 1 << LevelBits;
+	static constexpr int32 NumSlots = RootSlots + (Levels - 1) * LevelSlots;
+	// longest delay the wheels can hold, about 12 days, longer ones are clamped
+	static constexpr uint64 MaxTicks = 1ull << (RootBits + (Levels - 1) * LevelBits);
+
+	struct FNode
+	{
+		FMovementTimerCallback Callback;
+		uint64 ExpireTick = 0;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+		// INDEX_NONE while the node is free
+		int32 Slot = INDEX_NONE;
+		uint32 Serial = 0;
+	};
+
+	int32 SlotFor(uint64 ExpireTick) const;
+	void Link(int32 NodeIndex);
+	void Unlink(int32 NodeIndex);
+	void FreeNode(int32 NodeIndex);
+	// moves the current slot of a coarser wheel down, returns that slot's position in its wheel
+	int32 Cascade(int32 Level);
+	int32 FireSlot(int32 Slot);
+
+	TArray<FNode> Nodes;
+	// free nodes are chained through Next
+	int32 FreeHead = INDEX_NONE;
+	int32 SlotHeads[NumSlots];
+	uint64 CurrentTick = 0;
+	// time since CurrentTick
+	float Accumulator = 0.0f;
+	int32 NumScheduled = 0;
+	// callbacks of the slot being fired, kept to reuse the allocation
+	TArray<FMovementTimerCallback> Batch;
+};
+
+/**
+ * World timer wheel for the gameplay timers that used to be checked by ticking every object:
+ * grapple cooldowns, hook time of flight and projectile lifetimes.
+ * Callbacks run when the tickable objects tick, after the actors of the frame.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UMovementTimerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	FMovementTimerHandle Schedule(float Delay, const FMovementTimerCallback& Callback);
+	bool Cancel(FMovementTimerHandle& Handle);
+	bool IsScheduled(const FMovementTimerHandle& Handle) const { return Wheel.IsScheduled(Handle); };
+
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	FMovementTimerWheel Wheel;
+};
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UCurveFloat;
+
+/**
+ * Float curve baked into evenly spaced samples over the curve's time range.
+ * Evaluating is one lerp between two samples, the cost doesn't depend on the number of keys.
+ * Times outside the range use the first or last value, like the curve's constant extrapolation.
+ * Without a curve every sample is DefaultValue.
+ */
+struct MOVEMENTMECHANICS_API FBakedMovementCurve
+{
+	static constexpr int32 NumSamples = 64;
+
+	void Bake(const UCurveFloat* Curve, float DefaultValue = 1.0f);
+
+	float Evaluate(float Time) const
+	{
+		const float position = FMath::Clamp((Time - StartTime) * InvStep, 0.0f, (float)(NumSamples - 1));
+		const int32 index = FMath::Min((int32)position, NumSamples - 2);
+		return FMath::Lerp(Samples[index], Samples[index + 1], position - index);
+	}
+
+private:
+	float Samples[NumSamples] = {};
+	float StartTime = 0.0f;
+	// samples per second, 0 for a constant
+	float InvStep = 0.0f;
+};
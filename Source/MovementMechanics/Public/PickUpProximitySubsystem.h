@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PickUpProximitySubsystem.generated.h"
+
+class UTP_PickUpComponent;
+class AMovementMechanicsCharacter;
+
+/**
+ * Keeps the position and radius of every pick up in a spatial hash and tests them against the
+ * characters each frame, so pick ups don't need their own collision or overlap events.
+ * Pick ups are expected not to move while they are registered.
+ */
+UCLASS()
+class MOVEMENTMECHANICS_API UPickUpProximitySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void RegisterPickUp(UTP_PickUpComponent* PickUp);
+	void UnregisterPickUp(UTP_PickUpComponent* PickUp);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// sphere against capsule tests done by the last tick
+	int32 GetLastTestCount() const { return LastTestCount; };
+	SIZE_T GetAllocatedSize() const;
+
+protected:
+	struct FPickUpEntry
+	{
+		FVector Location;
+		float Radius;
+		FIntVector Cell;
+		TWeakObjectPtr<UTP_PickUpComponent> PickUp;
+	};
+
+	FIntVector GetCell(const FVector& Location) const;
+	void RemoveEntry(int32 Index);
+	void UpdateMemoryStat();
+
+	// size of a hash cell, bigger than any pick up so a pick up is only stored in one cell
+	float CellSize = 500.0f;
+	// biggest pick up radius registered, extends the cells searched around a character
+	float MaxRadius = 0.0f;
+
+	TSparseArray<FPickUpEntry> Entries;
+	TMap<FIntVector, TArray<int32>> Cells;
+	TMap<TWeakObjectPtr<UTP_PickUpComponent>, int32> EntryIndices;
+	// allocations of the cell arrays, kept up to date on each insert and remove instead of walking the cells
+	SIZE_T CellArrayBytes = 0;
+	int32 LastTestCount = 0;
+	// pick ups reached this frame, kept to reuse the allocation
+	TArray<TPair<TWeakObjectPtr<UTP_PickUpComponent>, AMovementMechanicsCharacter*>> PickedUp;
+};
@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "TP_PickUpComponent.h"
+#include "PickUpProximitySubsystem.h"
 
 UTP_PickUpComponent::UTP_PickUpComponent()
 {
@@ -12,10 +13,56 @@ void UTP_PickUpComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// Register our Overlap Event
+	UPickUpProximitySubsystem* ProximitySubsystem = GetWorld()->GetSubsystem<UPickUpProximitySubsystem>();
+	if (bUseProximitySubsystem && ProximitySubsystem != nullptr && GetAttachParentActor() == nullptr)
+	{
+		// The subsystem does the overlap test, so keep this sphere out of the physics scene
+		CollisionBeforeProximity = GetCollisionEnabled();
+		SetGenerateOverlapEvents(false);
+		SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		ProximitySubsystem->RegisterPickUp(this);
+		TransformUpdated.AddUObject(this, &UTP_PickUpComponent::OnMovedWhileRegistered);
+	}
+	else
+	{
+		// Register our Overlap Event
+		OnComponentBeginOverlap.AddDynamic(this, &UTP_PickUpComponent::OnSphereBeginOverlap);
+	}
+}
+
+void UTP_PickUpComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UPickUpProximitySubsystem* ProximitySubsystem = GetWorld()->GetSubsystem<UPickUpProximitySubsystem>())
+	{
+		ProximitySubsystem->UnregisterPickUp(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UTP_PickUpComponent::OnMovedWhileRegistered(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	TransformUpdated.RemoveAll(this);
+	if (UPickUpProximitySubsystem* ProximitySubsystem = GetWorld()->GetSubsystem<UPickUpProximitySubsystem>())
+	{
+		ProximitySubsystem->UnregisterPickUp(this);
+	}
+
+	// Back in the physics scene, from now on the overlap events find the characters
+	SetCollisionEnabled(CollisionBeforeProximity);
+	SetGenerateOverlapEvents(true);
 	OnComponentBeginOverlap.AddDynamic(this, &UTP_PickUpComponent::OnSphereBeginOverlap);
 }
 
+void UTP_PickUpComponent::NotifyPickedUp(AMovementMechanicsCharacter* Character)
+{
+	// The subsystem already dropped this pick up, whoever picked it up may attach it now
+	TransformUpdated.RemoveAll(this);
+
+	// Notify that the actor is being picked up
+	OnPickUp.Broadcast(Character);
+}
+
 void UTP_PickUpComponent::OnSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
 	// Checking if it is a First Person Character overlapping
@@ -27,5 +74,9 @@ void UTP_PickUpComponent::OnSphereBeginOverlap(UPrimitiveComponent* OverlappedCo
 
 		// Unregister from the Overlap Event so it is no longer triggered
 		OnComponentBeginOverlap.RemoveAll(this);
+
+		// Nothing else needs this sphere, take it out of the physics scene
+		SetGenerateOverlapEvents(false);
+		SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	}
 }
@@ -22,13 +22,30 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Interaction")
 	FOnPickUp OnPickUp;
 
+	/** Use the world's proximity subsystem instead of this component's own overlap events, for pick ups that
+	 *  never move. One that moves anyway goes back to overlap events. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Interaction")
+	bool bUseProximitySubsystem = false;
+
 	UTP_PickUpComponent();
+
+	/** Called by the proximity subsystem when a character reaches this pick up */
+	void NotifyPickedUp(AMovementMechanicsCharacter* Character);
 protected:
 
 	/** Called when the game starts */
 	virtual void BeginPlay() override;
 
+	/** Called when the game ends or the component is destroyed */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/** Code for when something overlaps this component */
 	UFUNCTION()
 	void OnSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	/** Leaves the proximity subsystem, whose hash only holds pick ups that stay where they are */
+	void OnMovedWhileRegistered(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	/** Collision of the sphere before the proximity subsystem took it out of the physics scene */
+	ECollisionEnabled::Type CollisionBeforeProximity = ECollisionEnabled::QueryOnly;
 };
\ No newline at end of file
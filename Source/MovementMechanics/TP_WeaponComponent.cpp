@@ -4,6 +4,7 @@
 #include "TP_WeaponComponent.h"
 #include "MovementMechanicsCharacter.h"
 #include "MovementMechanicsProjectile.h"
+#include "HitscanTraceSubsystem.h"
 #include "GameFramework/PlayerController.h"
 #include "Camera/PlayerCameraManager.h"
 #include "Kismet/GameplayStatics.h"
@@ -23,8 +24,24 @@ void UTP_WeaponComponent::Fire()
 		return;
 	}
 
+	// Queue a hitscan shot, all the shots of the frame are traced together
+	if (FireMode == EWeaponFireMode::Hitscan)
+	{
+		UWorld* const World = GetWorld();
+		UHitscanTraceSubsystem* HitscanSubsystem = World ? World->GetSubsystem<UHitscanTraceSubsystem>() : nullptr;
+		APlayerController* PlayerController = Cast<APlayerController>(Character->GetController());
+		// AI controlled characters have no camera to aim with
+		if (HitscanSubsystem != nullptr && PlayerController != nullptr && PlayerController->PlayerCameraManager != nullptr)
+		{
+			const FRotator ShotRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
+			const FVector ShotStart = GetOwner()->GetActorLocation() + ShotRotation.RotateVector(MuzzleOffset);
+			const FVector ShotEnd = ShotStart + ShotRotation.Vector() * HitscanRange;
+
+			HitscanSubsystem->QueueShot(ShotStart, ShotEnd, HitscanImpulse, Character);
+		}
+	}
 	// Try and fire a projectile
-	if (ProjectileClass != nullptr)
+	else if (ProjectileClass != nullptr)
 	{
 		UWorld* const World = GetWorld();
 		if (World != nullptr)
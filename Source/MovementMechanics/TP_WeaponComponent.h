@@ -8,12 +8,33 @@
 
 class AMovementMechanicsCharacter;
 
+UENUM()
+enum class EWeaponFireMode : uint8
+{
+	// spawns ProjectileClass at the muzzle
+	Projectile  UMETA(DisplayName = "Projectile"),
+	// queues an instant ray that is traced with every other shot of the frame
+	Hitscan     UMETA(DisplayName = "Hitscan"),
+};
+
 UCLASS(Blueprintable, BlueprintType, ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class MOVEMENTMECHANICS_API UTP_WeaponComponent : public UActorComponent
 {
 	GENERATED_BODY()
 
 public:
+	/** How the weapon fires */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
+	EWeaponFireMode FireMode = EWeaponFireMode::Projectile;
+
+	/** Max distance of a hitscan shot */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
+	float HitscanRange = 10000.0f;
+
+	/** Impulse given to physics objects hit by a hitscan shot, matches the projectile's velocity * 100 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
+	float HitscanImpulse = 300000.0f;
+
 	/** Projectile class to spawn */
 	UPROPERTY(EditDefaultsOnly, Category=Projectile)
 	TSubclassOf<class AMovementMechanicsProjectile> ProjectileClass;
@@ -3,22 +3,42 @@
 #include "MovementMechanicsCharacter.h"
 #include "MovementMechanicsProjectile.h"
 #include "GrapplingHookComponent.h"
+#include "MovementMechanicsStats.h"
+#include "MovementMechanicsCollision.h"
+#include "GrappleRewindSubsystem.h"
+#include "MovementAnimInstance.h"
+#include "MovementMechanicsMovementComponent.h"
+#include "MovementNavLinkComponent.h"
+#include "IAnimationBudgetAllocator.h"
 #include "Animation/AnimInstance.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
 #include "GameFramework/InputSettings.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameStateBase.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Net/UnrealNetwork.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
+
+// the wall run factors applied once per tick were tuned at this tick rate, they are converted to per second with it
+static constexpr float WallRunTuningRate = 60.0f;
+
+static_assert(FMovementSnapshot::NumBufferedInputs == (int32)EBufferedInput::Count, "the snapshot keeps one pending press per buffered input");
 
 //////////////////////////////////////////////////////////////////////////
 // AMovementMechanicsCharacter
 
-AMovementMechanicsCharacter::AMovementMechanicsCharacter()
+AMovementMechanicsCharacter::AMovementMechanicsCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UMovementSkeletalMeshComponent>(ACharacter::MeshComponentName)
+		.SetDefaultSubobjectClass<UMovementMechanicsMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(55.f, 96.0f);
 
+	// input and wall run logic have to run before the movement component integrates the frame
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
 	// set our turn rates for input
 	TurnRateGamepad = 45.f;
 
@@ -29,7 +49,7 @@ AMovementMechanicsCharacter::AMovementMechanicsCharacter()
 	FirstPersonCameraComponent->bUsePawnControlRotation = true;
 
 	// Create a mesh component that will be used when being viewed from a '1st person' view (when controlling this pawn)
-	Mesh1P = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("CharacterMesh1P"));
+	Mesh1P = CreateDefaultSubobject<UMovementSkeletalMeshComponent>(TEXT("CharacterMesh1P"));
 	Mesh1P->SetOnlyOwnerSee(true);
 	Mesh1P->SetupAttachment(FirstPersonCameraComponent);
 	Mesh1P->bCastDynamicShadow = false;
@@ -50,8 +70,64 @@ void AMovementMechanicsCharacter::BeginPlay()
 
 	if (!GrappleHookComponent)
 	{
-		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, TEXT("ERROR WITH GRAPLE HOOK COMPONENT"));
+		UE_VLOG_UELOG(this, LogMovementMechanics, Error, TEXT("%s has no grapple hook component"), *GetName());
+	}
+	else
+	{
+		GrappleHookComponent->OnGrappleDetached.AddDynamic(this, &AMovementMechanicsCharacter::OnGrappleDetached);
+		GrappleHookComponent->OnGrappleStateChanged.AddDynamic(this, &AMovementMechanicsCharacter::OnGrappleStateChanged);
 	}
+	MovementState = PlayerCharacterMovement->IsFalling() ? EMovementState::Falling : EMovementState::Grounded;
+
+	// the curves are only read here, the ticks sample the tables
+	WallRunGravityTable.Bake(WallRunGravityCurve);
+	WallRunSpeedTable.Bake(WallRunSpeedCurve);
+
+	// the anim instances read the movement state as the meshes update, so they have to tick after the movement component
+	Mesh1P->PrimaryComponentTick.AddPrerequisite(PlayerCharacterMovement, PlayerCharacterMovement->PrimaryComponentTick);
+	GetMesh()->PrimaryComponentTick.AddPrerequisite(PlayerCharacterMovement, PlayerCharacterMovement->PrimaryComponentTick);
+
+	// the movement component uses the velocity set by the wall run and the forces added by the grapple in the same frame
+	PlayerCharacterMovement->PrimaryComponentTick.AddPrerequisite(this, PrimaryActorTick);
+	if (GrappleHookComponent)
+	{
+		GrappleHookComponent->PrimaryComponentTick.AddPrerequisite(this, PrimaryActorTick);
+		PlayerCharacterMovement->PrimaryComponentTick.AddPrerequisite(GrappleHookComponent, GrappleHookComponent->PrimaryComponentTick);
+	}
+
+	// camera tilt follows the wall run state after the movement of this frame
+	PostPhysicsTickFunction.Target = this;
+	PostPhysicsTickFunction.bCanEverTick = true;
+	PostPhysicsTickFunction.bStartWithTickEnabled = false;
+	PostPhysicsTickFunction.TickGroup = TG_PostPhysics;
+	PostPhysicsTickFunction.RegisterTickFunction(GetLevel());
+	PostPhysicsTickFunction.AddPrerequisite(PlayerCharacterMovement, PlayerCharacterMovement->PrimaryComponentTick);
+
+	// streams ahead of fast movement, the sources are only returned for player controlled characters
+	PredictedStreamingSourceName = FName(*FString::Printf(TEXT("%s_Predicted"), *GetName()));
+	GrappleStreamingSourceName = FName(*FString::Printf(TEXT("%s_Grapple"), *GetName()));
+	if (UWorldPartitionSubsystem* worldPartition = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>())
+		worldPartition->RegisterStreamingSourceProvider(this);
+
+	SelectMovementPolicy();
+	UpdateAnimationBudget();
+}
+
+void AMovementMechanicsCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	PostPhysicsTickFunction.UnRegisterTickFunction();
+	if (UWorldPartitionSubsystem* worldPartition = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>())
+		worldPartition->UnregisterStreamingSourceProvider(this);
+	if (UMovementTimerSubsystem* timers = GetWorld()->GetSubsystem<UMovementTimerSubsystem>())
+		timers->Cancel(GrappleCooldownTimer);
+	Super::EndPlay(EndPlayReason);
+}
+
+void AMovementMechanicsCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	// the owner runs the mechanics itself
+	DOREPLIFETIME_CONDITION(AMovementMechanicsCharacter, ProxyState, COND_SimulatedOnly);
 }
 
 //////////////////////////////////////////////////////////////////////////// Input
@@ -74,6 +150,9 @@ void AMovementMechanicsCharacter::SetupPlayerInputComponent(class UInputComponen
 	// Enable touchscreen input
 	EnableTouchscreenMovement(PlayerInputComponent);
 
+	// the input component exists now, switch to the player version of the tick
+	SelectMovementPolicy();
+
 	// Bind movement events
 	PlayerInputComponent->BindAxis("Move Forward / Backward", this, &AMovementMechanicsCharacter::MoveForward);
 	PlayerInputComponent->BindAxis("Move Right / Left", this, &AMovementMechanicsCharacter::MoveRight);
@@ -120,12 +199,50 @@ void AMovementMechanicsCharacter::EndTouch(const ETouchIndex::Type FingerIndex,
 
 void AMovementMechanicsCharacter::Jump()
 {
+	BufferInput(EBufferedInput::Jump, GetWorld()->GetTimeSeconds());
+}
+
+void AMovementMechanicsCharacter::PerformJump()
+{
+	// as if the key was pressed this frame, the engine counts the jump from it
 	bPressedJump = true;
 	JumpKeyHoldTime = 0.0f;
-	if (JumpCurrentCount < JumpMaxCount)
-		LaunchCharacter(FindLaunchVelocity(), false, false);
-	if (WallRunning)
-		EndWallRun();
+	LaunchCharacter(FindLaunchVelocity(), false, false);
+	StartLatencyProbe(FVector::UpVector);
+	if (IsWallRunning())
+		DispatchMovementEvent(EMovementEvent::WallLost);
+	// one push off per wall
+	WallRunEndTime = -1000.0f;
+}
+
+void AMovementMechanicsCharacter::BufferInput(EBufferedInput Input, double PressTime)
+{
+	// producer side, the presses are drained by the movement tick
+	if (!InputBuffer.Push(Input, PressTime))
+		UE_LOG(LogMovementMechanics, Verbose, TEXT("%s: input buffer full, press dropped"), *GetName());
+}
+
+void AMovementMechanicsCharacter::ProcessBufferedInput()
+{
+	const double now = GetWorld()->GetTimeSeconds();
+
+	if (InputBuffer.IsPending(EBufferedInput::Jump, now, JumpBufferTime) && JumpCurrentCount < JumpMaxCount)
+	{
+		InputBuffer.Consume(EBufferedInput::Jump);
+		PerformJump();
+	}
+
+	ProcessBufferedGrapple();
+}
+
+void AMovementMechanicsCharacter::ProcessBufferedGrapple()
+{
+	if (InputBuffer.IsPending(EBufferedInput::Grapple, GetWorld()->GetTimeSeconds(), GrappleBufferTime) && GrappleHookComponent
+		&& !GrappleHookComponent->IsInUse() && GrappleHookComponent->GetTimeSinceLastGrappleDetach() > GrappleCooldown)
+	{
+		InputBuffer.Consume(EBufferedInput::Grapple);
+		ShootGrappleRay();
+	}
 }
 void AMovementMechanicsCharacter::ResetJumpState()
 {
@@ -143,25 +260,87 @@ void AMovementMechanicsCharacter::ResetJumpState()
 
 void AMovementMechanicsCharacter::Landed(const FHitResult& Hit)
 {
-	EndWallRun();
+	DispatchMovementEvent(EMovementEvent::Landed);
+	if (bTraversingNavLink)
+	{
+		bTraversingNavLink = false;
+		SetScriptedAxes(0.0f, 0.0f);
+	}
+}
+
+void AMovementMechanicsCharacter::OnGrappleDetached()
+{
+	GrappleCooldownEndTime = GetWorld()->GetTimeSeconds() + GrappleCooldown;
+	OnGrappleCooldownStarted.Broadcast(GrappleCooldownEndTime);
+	ScheduleGrappleCooldownEnd();
+}
+
+void AMovementMechanicsCharacter::ScheduleGrappleCooldownEnd()
+{
+	UMovementTimerSubsystem* timers = GetWorld()->GetSubsystem<UMovementTimerSubsystem>();
+	if (!timers)
+		return;
+
+	timers->Cancel(GrappleCooldownTimer);
+	const float remaining = GrappleCooldownEndTime - GetWorld()->GetTimeSeconds();
+	if (remaining > 0.0f)
+		GrappleCooldownTimer = timers->Schedule(remaining, FMovementTimerCallback::Create<AMovementMechanicsCharacter, &AMovementMechanicsCharacter::OnGrappleCooldownEnded>(this));
+}
+
+void AMovementMechanicsCharacter::OnGrappleCooldownEnded()
+{
+	// a grapple pressed during the end of the cooldown, among the presses the last tick drained
+	ProcessBufferedGrapple();
+	OnGrappleCooldownFinished.Broadcast();
+}
+
+float AMovementMechanicsCharacter::GetTimeSinceLastGrappleDetach()
+{
+	if (GrappleHookComponent)
+		return GrappleHookComponent->GetTimeSinceLastGrappleDetach();
+	return TimeSinceLastGrappleDetach;
+}
+
+float AMovementMechanicsCharacter::GetGrappleCooldownProgress() const
+{
+	if (GrappleCooldown <= 0.0f)
+		return 1.0f;
+
+	float remaining = GrappleCooldownEndTime - GetWorld()->GetTimeSeconds();
+	return FMath::Clamp(1.0f - remaining / GrappleCooldown, 0.0f, 1.0f);
 }
 
 void AMovementMechanicsCharacter::OnCompHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
-	if (CanSurfaceBeWallRan(Hit.ImpactNormal))
+	const bool runnable = CanSurfaceBeWallRan(Hit.ImpactNormal);
+	UE_VLOG_ARROW(this, LogMovementMechanics, VeryVerbose, Hit.ImpactPoint, Hit.ImpactPoint + Hit.ImpactNormal * 50.0f,
+		runnable ? FColor::Green : FColor::Silver, TEXT("Hit %s, %s"), *GetNameSafe(OtherActor), runnable ? TEXT("runnable") : TEXT("not runnable"));
+	if (runnable)
 	{
 		if(PlayerCharacterMovement->IsFalling())
 		{
 
-			if(!WallRunning)
+			if(!IsWallRunning())
 				FindRunDirectionAndSide(Hit.ImpactNormal);
 
 			if (AreRequiredKeysDown() && GetActorLocation().Z > WallHeight)
-				BeginWallRun();
+			{
+				// starts the wall run, or moves it to this wall when already running
+				const bool newWall = IsWallRunning() && !Hit.ImpactNormal.Equals(CachedWallNormal);
+				CacheWallPlane(Hit);
+				DispatchMovementEvent(EMovementEvent::WallHit);
+				// the old exit belongs to the previous wall, follow the new one and look for its end
+				if (newWall)
+				{
+					UpdateWallRun(Hit.ImpactNormal, 0.0f);
+					if (IsWallRunning() && bCacheWallPlane)
+						PredictWallExit();
+				}
+			}
 			else
 			{
-				if (WallRunning)
-					EndWallRun();
+				if (IsWallRunning())
+					DispatchMovementEvent(EMovementEvent::WallLost);
 			}
 			
 		}
@@ -172,9 +351,9 @@ FVector AMovementMechanicsCharacter::FindLaunchVelocity()
 {
 	FVector launchDirection;
 
-	// if wall running
+	// if wall running, or it just ended
 	// jump away from the wall
-	if (WallRunning)
+	if (IsWallRunning() || (PlayerCharacterMovement->IsFalling() && GetWorld()->GetTimeSeconds() - WallRunEndTime <= WallJumpCoyoteTime))
 	{
 		FVector up;
 		switch (WallSide)
@@ -211,6 +390,11 @@ FVector AMovementMechanicsCharacter::FindLaunchVelocity()
 }
 
 bool AMovementMechanicsCharacter::CanSurfaceBeWallRan(const FVector ImpactNormal)
+{
+	return IsWallRunnableSurface(ImpactNormal, PlayerCharacterMovement->GetWalkableFloorAngle());
+}
+
+bool AMovementMechanicsCharacter::IsWallRunnableSurface(const FVector& ImpactNormal, float WalkableFloorAngle)
 {
 	// if the z component of the surface is very smal then it can't be wall ran
 	if(ImpactNormal.Z < -0.05)
@@ -225,7 +409,7 @@ bool AMovementMechanicsCharacter::CanSurfaceBeWallRan(const FVector ImpactNormal
 		float slope = FVector::DotProduct(ImpactNormal, normalXYplane);
 		float angleOfWall = UKismetMathLibrary::DegAcos(slope);
 
-		if (angleOfWall < PlayerCharacterMovement->GetWalkableFloorAngle())
+		if (angleOfWall < WalkableFloorAngle)
 			return true;
 		else
 			return false;
@@ -268,52 +452,174 @@ bool AMovementMechanicsCharacter::AreRequiredKeysDown()
 		return false;
 }
 
-void AMovementMechanicsCharacter::BeginWallRun()
+void AMovementMechanicsCharacter::EnterWallRun()
 {
+	// the wall plane was cached from the hit that started the run
+	WallRunTraceCount = 0;
+	PredictWallExit();
 
 	NormalGravity = PlayerCharacterMovement->GravityScale;
-	PlayerCharacterMovement->GravityScale = GravityScale;
+	WallRunStartTime = GetWorld()->GetTimeSeconds();
+	PlayerCharacterMovement->GravityScale = GravityScale * WallRunGravityTable.Evaluate(0.0f);
 	PlayerCharacterMovement->AirControl = 1.0f;
 	//PlayerCharacterMovement->SetPlaneConstraintNormal(FVector(0, 0, 1));
 	JumpCurrentCount = 0;
-	WallRunning = true;
-	PlayerCharacterMovement->MaxWalkSpeed = WalkingSpeed;
-	CameraTilted = true;
+	PlayerCharacterMovement->MaxWalkSpeed = WalkingSpeed * WallRunSpeedTable.Evaluate(0.0f);
+	OnWallRunBegin.Broadcast(WallSide);
 }
 
-void AMovementMechanicsCharacter::EndWallRun()
+void AMovementMechanicsCharacter::ExitWallRun(EMovementEvent Event)
 {
 	PlayerCharacterMovement->GravityScale = 1.0f;
 	PlayerCharacterMovement->AirControl = 0.05f;
 	PlayerCharacterMovement->SetPlaneConstraintNormal(FVector(0, 0, 0));
 	PlayerCharacterMovement->MaxWalkSpeed = 800;
-	CameraTilted = false;
-	WallRunning = false;
-	
+	// only falling off the wall leaves a late wall jump, landing or grappling uses it up
+	WallRunEndTime = Event == EMovementEvent::WallLost ? GetWorld()->GetTimeSeconds() : -1000.0f;
+
+	LastWallRunTraceCount = WallRunTraceCount;
+	UE_LOG(LogMovementMechanics, Verbose, TEXT("Wall run ended after %d traces"), WallRunTraceCount);
+	OnWallRunEnd.Broadcast();
 }
 
-void AMovementMechanicsCharacter::UpdateWallRun(FHitResult Hit)
+void AMovementMechanicsCharacter::TickWallRun(float DeltaSeconds)
 {
+	SCOPE_CYCLE_COUNTER(STAT_MovementStateWallRunning);
+	// stick to the wall until the run ends
+	if (!bCacheWallPlane || ShouldRevalidateWall(DeltaSeconds))
+	{
+		FHitResult hit;
+		if (ShootRayToWall(hit))
+		{
+			bool newSegment = !hit.ImpactNormal.Equals(CachedWallNormal);
+			CacheWallPlane(hit);
+			UpdateWallRun(hit.ImpactNormal, DeltaSeconds);
+			// the wall changed or we ran past the predicted exit without the wall ending, look for the next one
+			if (IsWallRunning() && bCacheWallPlane && (newSegment || (!bWallEdgePredicted && FVector::DotProduct(GetActorLocation() - PredictedWallExit, WallRunDirection) >= 0.0f)))
+				PredictWallExit();
+		}
+		else
+		{
+			DispatchMovementEvent(EMovementEvent::WallLost);
+		}
+	}
+	else if (IsNearCachedWall())
+	{
+		UpdateWallRun(CachedWallNormal, DeltaSeconds);
+	}
+	else
+	{
+		DispatchMovementEvent(EMovementEvent::WallLost);
+	}
+}
+
+// Movement state machine
+// one row per state, one column per event, Count marks a transition that should never happen
+static const EMovementState MovementTransitions[(int32)EMovementState::Count][(int32)EMovementEvent::Count] =
+{
+	//                 Landed                     StartedFalling               WallHit                      WallLost                    GrappleAttached              GrappleReleased
+	/* Grounded */    { EMovementState::Grounded,  EMovementState::Falling,     EMovementState::Count,       EMovementState::Count,      EMovementState::Grappling,   EMovementState::Grounded },
+	/* Falling */     { EMovementState::Grounded,  EMovementState::Falling,     EMovementState::WallRunning, EMovementState::Count,      EMovementState::Grappling,   EMovementState::Falling },
+	/* WallRunning */ { EMovementState::Grounded,  EMovementState::WallRunning, EMovementState::WallRunning, EMovementState::Falling,    EMovementState::Grappling,   EMovementState::WallRunning },
+	/* Grappling */   { EMovementState::Grappling, EMovementState::Grappling,   EMovementState::Grappling,   EMovementState::Count,      EMovementState::Count,       EMovementState::Falling },
+};
+
+#if !UE_BUILD_SHIPPING || ENABLE_VISUAL_LOG
+static const TCHAR* MovementEventNames[(int32)EMovementEvent::Count] =
+{
+	TEXT("Landed"), TEXT("StartedFalling"), TEXT("WallHit"), TEXT("WallLost"), TEXT("GrappleAttached"), TEXT("GrappleReleased")
+};
+#endif
+
+// enter, exit and per tick update of each state, null when there is nothing to do
+const AMovementMechanicsCharacter::FMovementStateActions AMovementMechanicsCharacter::MovementStateActions[(int32)EMovementState::Count] =
+{
+	/* Grounded */    { nullptr, nullptr, nullptr },
+	/* Falling */     { nullptr, nullptr, nullptr },
+	/* WallRunning */ { &AMovementMechanicsCharacter::EnterWallRun, &AMovementMechanicsCharacter::ExitWallRun, &AMovementMechanicsCharacter::TickWallRun },
+	/* Grappling */   { nullptr, nullptr, nullptr },
+};
+
+void AMovementMechanicsCharacter::DispatchMovementEvent(EMovementEvent Event)
+{
+	const EMovementState next = MovementTransitions[(int32)MovementState][(int32)Event];
+	if (next == EMovementState::Count)
+	{
+#if !UE_BUILD_SHIPPING
+		UE_LOG(LogMovementMechanics, Warning, TEXT("%s: illegal movement transition, %s while %s"), *GetName(), MovementEventNames[(int32)Event], *UEnum::GetValueAsString(MovementState));
+#endif
+		return;
+	}
+	if (next == MovementState)
+		return;
+
+	UE_VLOG(this, LogMovementMechanics, Log, TEXT("%s: %s -> %s"), MovementEventNames[(int32)Event],
+		*UEnum::GetValueAsString(MovementState), *UEnum::GetValueAsString(next));
+	const FMovementStateActions& current = MovementStateActions[(int32)MovementState];
+	if (current.Exit)
+		(this->*current.Exit)(Event);
+	MovementState = next;
+	const FMovementStateActions& entered = MovementStateActions[(int32)MovementState];
+	if (entered.Enter)
+		(this->*entered.Enter)();
+}
+
+void AMovementMechanicsCharacter::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PrevMovementMode, PreviousCustomMode);
+	if (bRestoringSnapshot)
+		return;
+
+	if (GetCharacterMovement()->IsFalling())
+		DispatchMovementEvent(EMovementEvent::StartedFalling);
+	else if (GetCharacterMovement()->IsMovingOnGround())
+		DispatchMovementEvent(EMovementEvent::Landed);
+}
+
+void AMovementMechanicsCharacter::OnGrappleStateChanged(TEnumAsByte<UGrappleState> NewState)
+{
+	if (NewState == ATTACHED)
+	{
+		DispatchMovementEvent(EMovementEvent::GrappleAttached);
+	}
+	else if (NewState == READY)
+	{
+		DispatchMovementEvent(EMovementEvent::GrappleReleased);
+		// grappling doesn't follow the movement mode, catch up if the grapple let go on the ground
+		if (!PlayerCharacterMovement->IsFalling())
+			DispatchMovementEvent(EMovementEvent::Landed);
+	}
+}
+
+void AMovementMechanicsCharacter::UpdateWallRun(const FVector& WallNormal, float DeltaSeconds)
+{
+	MOVEMENT_SCOPE_TIMER(STAT_MovementUpdateWallRun, EMovementTimer::UpdateWallRun);
 	if (!AreRequiredKeysDown())
 	{
-		EndWallRun();
+		DispatchMovementEvent(EMovementEvent::WallLost);
 		return;
 	}
 	WallSideENUM previousSide = WallSide;
-	FindRunDirectionAndSide(Hit.ImpactNormal);
+	FindRunDirectionAndSide(WallNormal);
 	// make sure side is the same
 	// if it is different then end wall run
 	if (previousSide != WallSide)
 	{
-		EndWallRun();
+		DispatchMovementEvent(EMovementEvent::WallLost);
 		return;
 	}
 
+	// tuning over the time spent on the wall
+	const float timeOnWall = GetWorld()->GetTimeSeconds() - WallRunStartTime;
+	const float gravityScale = GravityScale * WallRunGravityTable.Evaluate(timeOnWall);
+	PlayerCharacterMovement->GravityScale = gravityScale;
+	PlayerCharacterMovement->MaxWalkSpeed = WalkingSpeed * WallRunSpeedTable.Evaluate(timeOnWall);
+
+	// the vertical speed was scaled by the gravity scale once per tick, tuned at 60 ticks a second,
+	// the same decay over the time of this tick
 	float maxSpeed = PlayerCharacterMovement->GetMaxSpeed();
-	FVector playerVelocity = FVector(WallRunDirection.X * maxSpeed, WallRunDirection.Y * maxSpeed, PlayerCharacterMovement->Velocity.Z * GravityScale);
-	UE_LOG(LogTemp, Warning, TEXT("Velocity in X %f"), playerVelocity.X);
-	UE_LOG(LogTemp, Warning, TEXT("Velocity in Y %f"), playerVelocity.Y);
-	UE_LOG(LogTemp, Warning, TEXT("Velocity in Z %f"), playerVelocity.Z);
+	const float verticalDecay = FMath::Pow(FMath::Max(gravityScale, 0.0f), DeltaSeconds * WallRunTuningRate);
+	FVector playerVelocity = FVector(WallRunDirection.X * maxSpeed, WallRunDirection.Y * maxSpeed, PlayerCharacterMovement->Velocity.Z * verticalDecay);
 
 	PlayerCharacterMovement->Velocity = playerVelocity;
 
@@ -321,8 +627,31 @@ void AMovementMechanicsCharacter::UpdateWallRun(FHitResult Hit)
 
 bool AMovementMechanicsCharacter::ShootRayToWall(FHitResult& Hit)
 {
+	MOVEMENT_SCOPE_TIMER(STAT_MovementShootRayToWall, EMovementTimer::ShootRayToWall);
 	// get actor position
 	FVector startRay = GetActorLocation();
+	// end position of ray
+	FVector endRay = startRay + GetWallProbeDirection() * WallTraceLength;
+
+	// You can use FCollisionQueryParams to further configure the query
+	// Here we add ourselves to the ignored list so we won't block the trace
+	// simple collision is enough to find the wall
+	FCollisionQueryParams TraceParams = FCollisionQueryParams(SCENE_QUERY_STAT(WallRunTrace), false, this);
+
+
+	ECollisionChannel Channel = ECC_WallRun;
+
+	WallRunTraceCount++;
+	TimeSinceWallValidation = 0.0f;
+	// shoot a ray from the position of the actor to where the wall should be
+	const bool hit = GetWorld()->LineTraceSingleByChannel(Hit, startRay, endRay, Channel, TraceParams);
+	UE_VLOG_SEGMENT(this, LogMovementMechanics, Verbose, startRay, hit ? Hit.ImpactPoint : endRay, hit ? FColor::Green : FColor::Red,
+		TEXT("Wall probe %s"), hit ? TEXT("hit") : TEXT("missed"));
+	return hit;
+}
+
+FVector AMovementMechanicsCharacter::GetWallProbeDirection() const
+{
 	// get a vector from the actor to the wall
 	FVector up;
 	switch (WallSide)
@@ -336,88 +665,454 @@ bool AMovementMechanicsCharacter::ShootRayToWall(FHitResult& Hit)
 	default:
 		break;
 	}
-	FVector actorToWall = UKismetMathLibrary::Cross_VectorVector(WallRunDirection, up);
-	actorToWall *= 200;
-	// end position of ray
-	FVector endRay = startRay + actorToWall;
+	return UKismetMathLibrary::Cross_VectorVector(WallRunDirection, up);
+}
 
-	// You can use FCollisionQueryParams to further configure the query
-	// Here we add ourselves to the ignored list so we won't block the trace
-	FCollisionQueryParams TraceParams = FCollisionQueryParams(FName(TEXT("Trace")), true, this);
+void AMovementMechanicsCharacter::CacheWallPlane(const FHitResult& Hit)
+{
+	CachedWallNormal = Hit.ImpactNormal;
+	CachedWallPoint = Hit.ImpactPoint;
+}
 
+void AMovementMechanicsCharacter::PredictWallExit()
+{
+	FVector start = GetActorLocation();
+	FVector end = start + WallRunDirection * WallExitPredictionDistance;
 
-	ECollisionChannel Channel = ECC_WorldStatic;
+	// use a sphere smaller than the capsule so it doesn't start overlapping the wall we are running on
+	FCollisionShape shape = FCollisionShape::MakeSphere(GetCapsuleComponent()->GetScaledCapsuleRadius() * 0.5f);
+	FCollisionQueryParams TraceParams = FCollisionQueryParams(SCENE_QUERY_STAT(WallExitSweep), false, this);
 
-	// shoot a ray from the position of the actor to where the wall should be
-	return GetWorld()->LineTraceSingleByChannel(Hit, startRay, endRay, Channel, TraceParams);
-	
+	// anything blocking the run direction ends the wall segment
+	FHitResult hit;
+	WallRunTraceCount++;
+	float reach = WallExitPredictionDistance;
+	if (GetWorld()->SweepSingleByChannel(hit, start, end, FQuat::Identity, ECC_WallRun, shape, TraceParams))
+		reach = hit.Distance;
+
+	// so does the wall stopping before that, probe it from points further along the run
+	const FVector probe = GetWallProbeDirection() * WallTraceLength;
+	auto isWallAt = [&](float Distance)
+	{
+		const FVector from = start + WallRunDirection * Distance;
+		FHitResult probeHit;
+		WallRunTraceCount++;
+		return GetWorld()->LineTraceSingleByChannel(probeHit, from, from + probe, ECC_WallRun, TraceParams) && probeHit.ImpactNormal.Equals(CachedWallNormal);
+	};
+	bWallEdgePredicted = !isWallAt(reach);
+	if (bWallEdgePredicted)
+	{
+		// the edge is between the last probe on the wall and the first one off it
+		float onWall = 0.0f;
+		float offWall = reach;
+		while (offWall - onWall > FMath::Max(WallEdgeTolerance, 1.0f))
+		{
+			const float middle = (onWall + offWall) * 0.5f;
+			if (isWallAt(middle))
+				onWall = middle;
+			else
+				offWall = middle;
+		}
+		reach = onWall;
+	}
+	PredictedWallExit = start + WallRunDirection * reach;
+	UE_VLOG_SEGMENT(this, LogMovementMechanics, Verbose, start, PredictedWallExit, FColor::Yellow, TEXT(""));
+	UE_VLOG_LOCATION(this, LogMovementMechanics, Verbose, PredictedWallExit, shape.GetSphereRadius(), FColor::Yellow, TEXT("Predicted wall exit"));
+}
+
+bool AMovementMechanicsCharacter::ShouldRevalidateWall(float DeltaSeconds)
+{
+	TimeSinceWallValidation += DeltaSeconds;
+
+	// reached the end of the cached segment, when the wall stops there it is traced every frame until it is gone
+	if (FVector::DotProduct(GetActorLocation() - PredictedWallExit, WallRunDirection) >= 0.0f)
+		return true;
+
+	// the faster the player goes the sooner the wall has to be checked again
+	float interval = WallValidationInterval;
+	float speed = PlayerCharacterMovement->Velocity.Size2D();
+	if (speed > KINDA_SMALL_NUMBER)
+		interval = FMath::Min(interval, WallValidationDistance / speed);
+
+	return TimeSinceWallValidation >= interval;
 }
 
-void AMovementMechanicsCharacter::HandleCameraRotation()
+bool AMovementMechanicsCharacter::IsNearCachedWall()
 {
-	// rotate camera towards angle wanted
-	if (CameraTilted)
+	// same reach as the ray shot in ShootRayToWall
+	float distanceToWall = FVector::DotProduct(GetActorLocation() - CachedWallPoint, CachedWallNormal);
+	return distanceToWall >= 0.0f && distanceToWall <= WallTraceLength;
+}
+
+void AMovementMechanicsCharacter::HandleCameraRotation(float DeltaSeconds)
+{
+	// tilt away from the wall while wall running, back to level otherwise
+	float targetTilt = 0.0f;
+	if (IsWallRunning())
+		targetTilt = WallSide == LEFT ? -MaxCameraTilt : MaxCameraTilt;
+
+	// at CameraTiltSpeed degrees per second whatever the frame rate
+	const float currentTilt = FRotator::NormalizeAxis(GetControlRotation().Roll);
+	const float tilt = FMath::FInterpConstantTo(currentTilt, targetTilt, DeltaSeconds, CameraTiltSpeed);
+	if (tilt != currentTilt)
+		AddControllerRollInput(tilt - currentTilt);
+}
+
+// Movement policies
+// each pawn type gets its own compiled version of the movement tick, so the checks that never
+// change for a pawn are resolved at compile time instead of every frame
+
+// reads the axes bound in SetupPlayerInputComponent
+struct AMovementMechanicsCharacter::FPlayerInputPolicy
+{
+	static void ReadAxes(AMovementMechanicsCharacter& Character)
 	{
-		float currentTilt = GetControlRotation().Roll;
+		// looked up once instead of every tick
+		static const FName MoveForwardAxisName(TEXT("Move Forward / Backward"));
+		static const FName MoveRightAxisName(TEXT("Move Right / Left"));
+		Character.ForwardAxis = Character.InputComponent->GetAxisValue(MoveForwardAxisName);
+		Character.RightAxis = Character.InputComponent->GetAxisValue(MoveRightAxisName);
+	}
+};
 
-		float increase = 1.0f;
-		switch (WallSide)
-		{
-		case LEFT:
-			if (GetControlRotation().Roll > 330 || GetControlRotation().Roll <= 30)
-				AddControllerRollInput(-increase);
-			break;
-		case RIGHT:
-			if (GetControlRotation().Roll < 30 || GetControlRotation().Roll >= 330)
-				AddControllerRollInput(increase);
-			break;
-		default:
-			break;
-		}
+// no player input, use the scripted axes instead (bots, simulation commandlets)
+struct AMovementMechanicsCharacter::FScriptedInputPolicy
+{
+	static void ReadAxes(AMovementMechanicsCharacter& Character)
+	{
+		Character.ForwardAxis = Character.ScriptedForwardAxis;
+		Character.RightAxis = Character.ScriptedRightAxis;
+		Character.MoveForward(Character.ForwardAxis);
+		Character.MoveRight(Character.RightAxis);
 	}
-	// rotate camera back to 0 degree
-	else
+};
+
+// pawns controlled by a remote client, the server only knows the acceleration sent with the moves
+struct AMovementMechanicsCharacter::FReplicatedInputPolicy
+{
+	static void ReadAxes(AMovementMechanicsCharacter& Character)
 	{
-		// end should be zero
-		float increase = 1.0f;
-		float currentTilt = GetControlRotation().Roll;
-		if (currentTilt >= 330)
-			AddControllerRollInput(increase);
-		else if (currentTilt <= 30 && currentTilt > 0)
-			AddControllerRollInput(-increase);
+		const FVector acceleration = Character.PlayerCharacterMovement->GetCurrentAcceleration();
+		const float maxAcceleration = FMath::Max(Character.PlayerCharacterMovement->GetMaxAcceleration(), KINDA_SMALL_NUMBER);
+		Character.ForwardAxis = FVector::DotProduct(acceleration, Character.GetActorForwardVector()) / maxAcceleration;
+		Character.RightAxis = FVector::DotProduct(acceleration, Character.GetActorRightVector()) / maxAcceleration;
+	}
+};
+
+void AMovementMechanicsCharacter::Tick(float DeltaSeconds)
+{
+	LLM_SCOPE_BYTAG(MovementWallRun);
+	MOVEMENT_SCOPE_TIMER(STAT_MovementCharacterTick, EMovementTimer::CharacterTick);
+	(this->*TickMovementFunction)(DeltaSeconds);
+	if (HasAuthority())
+		UpdateProxyState();
+	// the HUD widget still reads this, only the local player's copy is shown
+	if (IsLocallyControlled())
+		TimeSinceLastGrappleDetach = GetTimeSinceLastGrappleDetach();
+}
 
+void AMovementMechanicsCharacter::UpdateProxyState()
+{
+	// rebuilt every tick, replication only sends it when a field changed
+	FMovementProxyState state;
+	state.GravityScale = PlayerCharacterMovement->GravityScale;
+	if (MovementState == EMovementState::Grappling && GrappleHookComponent && GrappleHookComponent->IsGrappleAttached())
+	{
+		state.bGrappling = true;
+		state.Anchor = GrappleHookComponent->GetCableAnchor();
+		state.PullForce = GrappleHookComponent->GetPullForce();
 	}
+	else if (MovementState == EMovementState::WallRunning)
+	{
+		state.bWallRunning = true;
+		state.WallNormal = CachedWallNormal;
+	}
+	ProxyState = state;
 }
 
-void AMovementMechanicsCharacter::Tick(float DeltaSeconds)
+void AMovementMechanicsCharacter::OnRep_ProxyState()
+{
+	if (UMovementMechanicsMovementComponent* movement = Cast<UMovementMechanicsMovementComponent>(GetCharacterMovement()))
+		movement->SetProxyState(ProxyState);
+}
+
+template<typename TInput>
+void AMovementMechanicsCharacter::TickMovement(float DeltaSeconds)
 {
-	if(GrappleHookComponent)
-		TimeSinceLastGrappleDetach = GrappleHookComponent->GetTimeSinceLastGrappleDetach();
 	ClampHorizontalVelocity();
-	ForwardAxis = InputComponent->GetAxisValue(FName("Move Forward / Backward"));
-	RightAxis = InputComponent->GetAxisValue(FName("Move Right / Left"));
+	const bool wasMoving = ForwardAxis != 0.0f || RightAxis != 0.0f;
+	TInput::ReadAxes(*this);
+	if (!wasMoving && (ForwardAxis != 0.0f || RightAxis != 0.0f))
+		StartLatencyProbe(GetActorForwardVector() * ForwardAxis + GetActorRightVector() * RightAxis);
+	// after the axes, a buffered jump launches in the direction held this frame
+	// the player controller handles input before its pawn ticks, so a press that can act does so on the frame it was made
+	InputBuffer.Drain();
+	ProcessBufferedInput();
+
+	// one dispatch to the update of the current state
+	if (void (AMovementMechanicsCharacter::*update)(float) = MovementStateActions[(int32)MovementState].Update)
+		(this->*update)(DeltaSeconds);
+}
 
-	if (GrappleHookComponent->IsGrappleAttached() && WallRunning)
-		EndWallRun();
+void FMovementPostPhysicsTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && IsValid(Target))
+		Target->TickPostPhysics(DeltaTime);
+}
 
-	// if falling and wall run has started then stick to the wall while WallRunning is true
-	if (PlayerCharacterMovement->IsFalling())
+FString FMovementPostPhysicsTickFunction::DiagnosticMessage()
+{
+	return Target ? Target->GetFullName() + TEXT("[TickPostPhysics]") : TEXT("<null>[TickPostPhysics]");
+}
+
+void AMovementMechanicsCharacter::TickPostPhysics(float DeltaSeconds)
+{
+	if (bTiltCamera)
+		HandleCameraRotation(DeltaSeconds);
+	if (bLatencyProbePending)
+		UpdateLatencyProbe();
+}
+
+void AMovementMechanicsCharacter::UpdatePostPhysicsTickEnabled()
+{
+	if (PostPhysicsTickFunction.IsTickFunctionRegistered())
+		PostPhysicsTickFunction.SetTickFunctionEnable(bTiltCamera || bLatencyProbePending);
+}
+
+void AMovementMechanicsCharacter::StartLatencyProbe(const FVector& Direction)
+{
+	// one input at a time, the next one is probed once this one is resolved
+	if (bLatencyProbePending || !(bProbeInputLatency || FMovementTimings::bRecording))
+		return;
+
+	LatencyProbeFrame = GFrameCounter;
+	LatencyProbeVelocity = GetVelocity();
+	LatencyProbeDirection = Direction.GetSafeNormal();
+	bLatencyProbePending = true;
+	UpdatePostPhysicsTickEnabled();
+}
+
+void AMovementMechanicsCharacter::UpdateLatencyProbe()
+{
+	const uint64 frames = GFrameCounter - LatencyProbeFrame;
+	// 1 cm/s in the direction of the input, gravity and friction don't count
+	if (FVector::DotProduct(GetVelocity() - LatencyProbeVelocity, LatencyProbeDirection) > 1.0f)
 	{
-		if (WallRunning)
-		{
-			FHitResult hit;
-			if (ShootRayToWall(hit))
-			{
-				UpdateWallRun(hit);
-			}
-			else
-			{
-				EndWallRun();
-			}
-		}
+		SET_DWORD_STAT(STAT_MovementInputLatencyFrames, (uint32)frames);
+		if (FMovementTimings::bRecording)
+			FMovementTimings::InputLatencyFrames.Add((double)frames);
+		UE_LOG(LogMovementMechanics, Verbose, TEXT("%s: input moved the character after %llu frames"), *GetName(), frames);
+	}
+	else if (frames < (uint64)MaxInputLatencyFrames)
+	{
+		return;
+	}
+	bLatencyProbePending = false;
+	UpdatePostPhysicsTickEnabled();
+}
+
+void AMovementMechanicsCharacter::SelectMovementPolicy()
+{
+	if (bMovementPolicyForced)
+		return;
+
+	if (IsLocallyControlled() && IsPlayerControlled() && InputComponent)
+		SetMovementPolicy(EMovementPolicy::Player);
+	else if (HasAuthority() && IsPlayerControlled() && !IsLocallyControlled())
+		SetMovementPolicy(EMovementPolicy::Server);
+	else
+		SetMovementPolicy(EMovementPolicy::Bot);
+}
+
+void AMovementMechanicsCharacter::SetMovementPolicy(EMovementPolicy Policy)
+{
+	// the player version reads the input component, don't use it without one
+	if (Policy == EMovementPolicy::Player && !InputComponent)
+		Policy = EMovementPolicy::Bot;
+
+	MovementPolicy = Policy;
+	switch (Policy)
+	{
+	case EMovementPolicy::Player:
+		TickMovementFunction = &AMovementMechanicsCharacter::TickMovement<FPlayerInputPolicy>;
+		break;
+	case EMovementPolicy::Server:
+		TickMovementFunction = &AMovementMechanicsCharacter::TickMovement<FReplicatedInputPolicy>;
+		break;
+	case EMovementPolicy::Bot:
+	default:
+		TickMovementFunction = &AMovementMechanicsCharacter::TickMovement<FScriptedInputPolicy>;
+		break;
+	}
+	// cosmetics run in the post physics tick, it is left disabled for the other pawns
+	bTiltCamera = Policy == EMovementPolicy::Player;
+	UpdatePostPhysicsTickEnabled();
+}
+
+void AMovementMechanicsCharacter::ForceMovementPolicy(EMovementPolicy Policy)
+{
+	bMovementPolicyForced = true;
+	SetMovementPolicy(Policy);
+}
+
+void AMovementMechanicsCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+	SelectMovementPolicy();
+	UpdateAnimationBudget();
+}
+
+void AMovementMechanicsCharacter::SaveSnapshot(FMovementSnapshot& Snapshot) const
+{
+	const float worldTime = GetWorld()->GetTimeSeconds();
+	Snapshot.Location = GetActorLocation();
+	Snapshot.Rotation = GetActorQuat();
+	Snapshot.ControlRotation = GetControlRotation();
+
+	Snapshot.JumpCurrentCount = JumpCurrentCount;
+	Snapshot.JumpCurrentCountPreJump = JumpCurrentCountPreJump;
+	Snapshot.JumpKeyHoldTime = JumpKeyHoldTime;
+	Snapshot.JumpForceTimeRemaining = JumpForceTimeRemaining;
+	Snapshot.bPressedJump = bPressedJump;
+	Snapshot.bWasJumping = bWasJumping;
+
+	Snapshot.ForwardAxis = ForwardAxis;
+	Snapshot.RightAxis = RightAxis;
+	Snapshot.ScriptedForwardAxis = ScriptedForwardAxis;
+	Snapshot.ScriptedRightAxis = ScriptedRightAxis;
+
+	Snapshot.MovementState = (uint8)MovementState;
+	Snapshot.WallSide = (uint8)WallSide;
+	Snapshot.WallRunDirection = WallRunDirection;
+	Snapshot.NormalGravity = NormalGravity;
+	Snapshot.CachedWallNormal = CachedWallNormal;
+	Snapshot.CachedWallPoint = CachedWallPoint;
+	Snapshot.PredictedWallExit = PredictedWallExit;
+	Snapshot.bWallEdgePredicted = bWallEdgePredicted;
+	Snapshot.TimeSinceWallValidation = TimeSinceWallValidation;
+	Snapshot.WallRunStartOffset = WallRunStartTime - worldTime;
+	Snapshot.WallRunEndOffset = WallRunEndTime - worldTime;
+	Snapshot.GrappleCooldownOffset = GrappleCooldownEndTime - worldTime;
+	// presses still in the ring are drained on the next tick and not saved
+	for (int32 i = 0; i < FMovementSnapshot::NumBufferedInputs; i++)
+	{
+		const double pressTime = InputBuffer.GetPendingTime((EBufferedInput)i);
+		Snapshot.bBufferedInputPending[i] = pressTime >= 0.0;
+		Snapshot.BufferedInputOffsets[i] = (float)(pressTime - worldTime);
 	}
-	HandleCameraRotation();
 
+	if (const UMovementMechanicsMovementComponent* movement = Cast<UMovementMechanicsMovementComponent>(PlayerCharacterMovement))
+		movement->SaveSnapshot(Snapshot.Movement);
+	if (GrappleHookComponent)
+		GrappleHookComponent->SaveSnapshot(Snapshot.Grapple);
+}
+
+void AMovementMechanicsCharacter::RestoreSnapshot(const FMovementSnapshot& Snapshot)
+{
+	SetActorLocationAndRotation(Snapshot.Location, Snapshot.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	if (AController* controller = GetController())
+		controller->SetControlRotation(Snapshot.ControlRotation);
+
+	// before the jump fields, changing the movement mode can reset them
+	if (UMovementMechanicsMovementComponent* movement = Cast<UMovementMechanicsMovementComponent>(PlayerCharacterMovement))
+	{
+		TGuardValue<bool> restoring(bRestoringSnapshot, true);
+		movement->RestoreSnapshot(Snapshot.Movement);
+	}
+
+	JumpCurrentCount = Snapshot.JumpCurrentCount;
+	JumpCurrentCountPreJump = Snapshot.JumpCurrentCountPreJump;
+	JumpKeyHoldTime = Snapshot.JumpKeyHoldTime;
+	JumpForceTimeRemaining = Snapshot.JumpForceTimeRemaining;
+	bPressedJump = Snapshot.bPressedJump;
+	bWasJumping = Snapshot.bWasJumping;
+
+	ForwardAxis = Snapshot.ForwardAxis;
+	RightAxis = Snapshot.RightAxis;
+	ScriptedForwardAxis = Snapshot.ScriptedForwardAxis;
+	ScriptedRightAxis = Snapshot.ScriptedRightAxis;
+
+	MovementState = (EMovementState)Snapshot.MovementState;
+	WallSide = (WallSideENUM)Snapshot.WallSide;
+	WallRunDirection = Snapshot.WallRunDirection;
+	NormalGravity = Snapshot.NormalGravity;
+	CachedWallNormal = Snapshot.CachedWallNormal;
+	CachedWallPoint = Snapshot.CachedWallPoint;
+	PredictedWallExit = Snapshot.PredictedWallExit;
+	bWallEdgePredicted = Snapshot.bWallEdgePredicted;
+	TimeSinceWallValidation = Snapshot.TimeSinceWallValidation;
+	WallRunStartTime = GetWorld()->GetTimeSeconds() + Snapshot.WallRunStartOffset;
+	WallRunEndTime = GetWorld()->GetTimeSeconds() + Snapshot.WallRunEndOffset;
+	GrappleCooldownEndTime = GetWorld()->GetTimeSeconds() + Snapshot.GrappleCooldownOffset;
+	ScheduleGrappleCooldownEnd();
+	InputBuffer.Reset();
+	for (int32 i = 0; i < FMovementSnapshot::NumBufferedInputs; i++)
+	{
+		if (Snapshot.bBufferedInputPending[i])
+			InputBuffer.SetPendingTime((EBufferedInput)i, GetWorld()->GetTimeSeconds() + Snapshot.BufferedInputOffsets[i]);
+	}
+
+	if (GrappleHookComponent)
+		GrappleHookComponent->RestoreSnapshot(Snapshot.Grapple);
+}
+
+void AMovementMechanicsCharacter::GetAnimSnapshot(FMovementAnimSnapshot& OutSnapshot) const
+{
+	OutSnapshot.Velocity = GetVelocity();
+	OutSnapshot.AimPitch = FRotator::NormalizeAxis(GetBaseAimRotation().Pitch);
+	OutSnapshot.bIsFalling = PlayerCharacterMovement && PlayerCharacterMovement->IsFalling();
+	OutSnapshot.bWallRunning = IsWallRunning();
+	OutSnapshot.WallSide = WallSide;
+	OutSnapshot.GrappleState = GrappleHookComponent ? GrappleHookComponent->GetGrappleState() : READY;
+}
+
+void AMovementMechanicsCharacter::UpdateAnimationBudget()
+{
+	UMovementSkeletalMeshComponent* mesh = Cast<UMovementSkeletalMeshComponent>(GetMesh());
+	IAnimationBudgetAllocator* budgetAllocator = GetWorld() ? IAnimationBudgetAllocator::Get(GetWorld()) : nullptr;
+	if (!mesh || !budgetAllocator || !(HasActorBegunPlay() || IsActorBeginningPlay()))
+		return;
+
+	// the local player always animates at full rate, a dedicated server doesn't need the budget
+	const bool shouldBudget = !IsLocallyControlled() && GetNetMode() != NM_DedicatedServer;
+	if (shouldBudget == bAnimationBudgeted)
+		return;
+
+	if (shouldBudget)
+		budgetAllocator->RegisterComponent(mesh);
+	else
+		budgetAllocator->UnregisterComponent(mesh);
+	bAnimationBudgeted = shouldBudget;
+}
+
+bool AMovementMechanicsCharacter::GetStreamingSources(TArray<FWorldPartitionStreamingSource>& OutStreamingSources) const
+{
+	if (!bPredictiveStreaming || !IsPlayerControlled())
+		return false;
+
+	const bool grappling = GrappleHookComponent && GrappleHookComponent->IsInUse();
+	auto addSource = [&](FName Name, const FVector& Location, const FColor& Color)
+	{
+		FWorldPartitionStreamingSource& source = OutStreamingSources.AddDefaulted_GetRef();
+		source.Name = Name;
+		source.Location = Location;
+		source.Rotation = GetActorRotation();
+		source.TargetState = EStreamingSourceTargetState::Activated;
+		// these only prefetch, the controller's source decides when the game has to wait
+		source.bBlockOnSlowLoading = false;
+		source.Priority = grappling ? EStreamingSourcePriority::High : EStreamingSourcePriority::Normal;
+		source.DebugColor = Color;
+	};
+
+	const FVector lookAhead = (GetVelocity() * StreamingLookAheadTime).GetClampedToMaxSize(MaxStreamingLookAhead);
+	if (!lookAhead.IsNearlyZero(1.0f))
+		addSource(PredictedStreamingSourceName, GetActorLocation() + lookAhead, FColor::Orange);
+
+	// the hook while it flies, then where the cable pulls the player
+	if (grappling)
+		addSource(GrappleStreamingSourceName, GrappleHookComponent->GetCableAnchor(), FColor::Cyan);
+
+	return OutStreamingSources.Num() > 0;
 }
 
 void AMovementMechanicsCharacter::UseGrapple()
@@ -430,12 +1125,8 @@ void AMovementMechanicsCharacter::UseGrapple()
 		}
 		else
 		{
-			if(GrappleHookComponent->GetTimeSinceLastGrappleDetach() > GrappleCooldown)
-				ShootGrappleRay();
-			else
-			{
-				GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Red, TEXT("Grapple is on cooldown"));
-			}
+			// fires now, or when the cooldown ends if that is within GrappleBufferTime
+			BufferInput(EBufferedInput::Grapple, GetWorld()->GetTimeSeconds());
 		}
 	}
 }
@@ -446,31 +1137,88 @@ void AMovementMechanicsCharacter::ShootGrappleRay()
 
 	FHitResult hit;
 	FVector  start = FirstPersonCameraComponent->GetComponentLocation();
-	FVector end = start + FirstPersonCameraComponent->GetForwardVector() * 10000;
+	FVector end = start + FirstPersonCameraComponent->GetForwardVector() * GrappleRayLength;
 
 	// You can use FCollisionQueryParams to further configure the query
 	// Here we add ourselves to the ignored list so we won't block the trace
-	FCollisionQueryParams TraceParams = FCollisionQueryParams(FName(TEXT("Trace")), true, this);
-	//const FName TraceTag("MyTraceTag");
-
-	//GetWorld()->DebugDrawTraceTag = TraceTag;
+	FCollisionQueryParams TraceParams = FCollisionQueryParams(SCENE_QUERY_STAT(GrappleTrace), false, this);
+	ECollisionChannel Channel = ECC_Grapple;
+	const bool bHit = GetWorld()->LineTraceSingleByChannel(hit, start, end, Channel, TraceParams);
 
-	//TraceParams.TraceTag = TraceTag;
-	ECollisionChannel Channel = ECC_WorldStatic;
+	// clients ask the server to fire too with what they hit, the server checks it against where things were when the client fired
+	if (GetLocalRole() < ROLE_Authority)
+	{
+		AGameStateBase* gameState = GetWorld()->GetGameState();
+		float serverTime = gameState ? gameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+		ServerShootGrappleRay(start, FirstPersonCameraComponent->GetForwardVector(), serverTime, bHit ? hit.GetActor() : nullptr, bHit ? hit.Location : end);
+	}
 
-	if (GetWorld()->LineTraceSingleByChannel(hit, start, end, Channel, TraceParams))
+	if (bHit)
 	{
+		UE_VLOG_SEGMENT(this, LogMovementMechanics, Log, start, hit.Location, FColor::Cyan, TEXT("Grapple trace hit %s"), *GetNameSafe(hit.GetActor()));
 		GrappleHookComponent->FireGrapple(hit.Location, SetGrappleLocalOffset());
 	}
 	else
+	{
+		UE_VLOG_SEGMENT(this, LogMovementMechanics, Log, start, hit.TraceEnd, FColor::Red, TEXT("Grapple trace missed"));
 		GrappleHookComponent->FireGrapple(hit.TraceEnd, SetGrappleLocalOffset());
+	}
 
 }
 
+void AMovementMechanicsCharacter::ServerShootGrappleRay_Implementation(FVector_NetQuantize Start, FVector_NetQuantizeNormal Direction, float ClientTimeStamp,
+	AActor* ClientHitActor, FVector_NetQuantize ClientHitLocation)
+{
+	if (!GrappleHookComponent || GrappleHookComponent->IsInUse() || GrappleHookComponent->GetTimeSinceLastGrappleDetach() <= GrappleCooldown)
+	{
+		UE_VLOG(this, LogMovementMechanics, Log, TEXT("Grapple shot rejected, the grapple is in use or cooling down"));
+		return;
+	}
+
+	// don't trust a start point that is far from the player
+	if (FVector::Distance(Start, FirstPersonCameraComponent->GetComponentLocation()) > MaxGrappleStartError)
+	{
+		UE_VLOG_LOCATION(this, LogMovementMechanics, Warning, (FVector)Start, 10.0f, FColor::Red, TEXT("Grapple shot rejected, start %.0fcm from the camera"),
+			FVector::Distance(Start, FirstPersonCameraComponent->GetComponentLocation()));
+		return;
+	}
+
+	const double validationStart = FPlatformTime::Seconds();
+	FVector end = Start + Direction.GetSafeNormal() * GrappleRayLength;
+	FHitResult hit;
+	bool bHit;
+	UGrappleRewindSubsystem* rewind = GetWorld()->GetSubsystem<UGrappleRewindSubsystem>();
+	if (rewind && rewind->IsRecording())
+	{
+		// don't rewind further than the history the server keeps
+		float oldest = GetWorld()->GetTimeSeconds() - MaxGrappleRewindTime;
+		bHit = rewind->RewindTrace(Start, end, FMath::Max(ClientTimeStamp, oldest), this, ECC_Grapple, hit);
+	}
+	else
+	{
+		FCollisionQueryParams TraceParams = FCollisionQueryParams(SCENE_QUERY_STAT(GrappleTrace), false, this);
+		bHit = GetWorld()->LineTraceSingleByChannel(hit, Start, end, ECC_Grapple, TraceParams);
+	}
+
+	// the client's hit stands when the rewound trace ends at the same place on the same actor,
+	// otherwise the hook goes where the server found it
+	const FVector serverTarget = bHit ? hit.Location : end;
+	const bool confirmed = FVector::Distance(serverTarget, ClientHitLocation) <= MaxGrappleHitError && (!bHit || hit.GetActor() == ClientHitActor);
+	if (rewind)
+		rewind->RecordValidation(confirmed, FPlatformTime::Seconds() - validationStart, GetWorld()->GetTimeSeconds() - ClientTimeStamp);
+
+	UE_VLOG_SEGMENT(this, LogMovementMechanics, Log, (FVector)Start, serverTarget, bHit ? FColor::Cyan : FColor::Red,
+		TEXT("Server grapple trace at %.3f %s"), ClientTimeStamp, bHit ? *GetNameSafe(hit.GetActor()) : TEXT("missed"));
+	if (!confirmed)
+		UE_VLOG_LOCATION(this, LogMovementMechanics, Log, (FVector)ClientHitLocation, 10.0f, FColor::Red, TEXT("Client grapple hit on %s not confirmed, %.0fcm away"),
+			*GetNameSafe(ClientHitActor), FVector::Distance(serverTarget, ClientHitLocation));
+	GrappleHookComponent->FireGrapple(confirmed ? (FVector)ClientHitLocation : serverTarget, SetGrappleLocalOffset());
+}
+
 FVector AMovementMechanicsCharacter::SetGrappleLocalOffset()
 {
 	FVector localOffset;
-	if (WallRunning)
+	if (IsWallRunning())
 	{
 		switch (WallSide)
 		{
@@ -511,6 +1259,30 @@ void AMovementMechanicsCharacter::ClampHorizontalVelocity()
 }
 
 
+void AMovementMechanicsCharacter::StartNavLinkTraversal(EMovementTraversal Traversal, const FVector& Anchor)
+{
+	switch (Traversal)
+	{
+	case EMovementTraversal::WallRun:
+		// the wall run needs the forward key held, the path following steers along the wall
+		SetScriptedAxes(1.0f, 0.0f);
+		ScriptedJump();
+		break;
+	case EMovementTraversal::Grapple:
+		// bots have no camera manager, aim the camera at the anchor the generator found
+		FirstPersonCameraComponent->SetWorldRotation((Anchor - FirstPersonCameraComponent->GetComponentLocation()).Rotation());
+		ScriptedGrapple();
+		break;
+	}
+	bTraversingNavLink = true;
+}
+
+void AMovementMechanicsCharacter::SetScriptedAxes(float Forward, float Right)
+{
+	ScriptedForwardAxis = Forward;
+	ScriptedRightAxis = Right;
+}
+
 void AMovementMechanicsCharacter::MoveForward(float Value)
 {
 	//player must be mpving forward to stuck to the wall
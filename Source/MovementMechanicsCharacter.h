@@ -4,6 +4,14 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Engine/NetSerialization.h"
+#include "WorldPartition/WorldPartitionStreamingSource.h"
+#include "MovementSnapshot.h"
+#include "GrapplingHookComponent.h"
+#include "MovementMechanicsMovementComponent.h"
+#include "MovementTimerSubsystem.h"
+#include "MovementInputBuffer.h"
+#include "MovementTuningCurve.h"
 
 #include "MovementMechanicsCharacter.generated.h"
 class UInputComponent;
@@ -13,6 +21,9 @@ class UCameraComponent;
 class UAnimMontage;
 class USoundBase;
 class UGrapplingHookComponent;
+class UCurveFloat;
+struct FMovementAnimSnapshot;
+enum class EMovementTraversal : uint8;
 
 UENUM()
 enum WallSideENUM
@@ -22,19 +33,76 @@ enum WallSideENUM
 };
 
 
+// State of the movement mechanics, see the transition table in the .cpp
+UENUM(BlueprintType)
+enum class EMovementState : uint8
+{
+	Grounded       UMETA(DisplayName = "Grounded"),
+	Falling        UMETA(DisplayName = "Falling"),
+	WallRunning    UMETA(DisplayName = "Wall Running"),
+	// the grapple is attached, it takes priority over the wall run
+	Grappling      UMETA(DisplayName = "Grappling"),
+	Count          UMETA(Hidden),
+};
+
+// Events sent to the movement state machine
+enum class EMovementEvent : uint8
+{
+	Landed,
+	StartedFalling,
+	// hit a wall that can be ran on with the keys held
+	WallHit,
+	// the wall ended, the keys were released or the player jumped off
+	WallLost,
+	GrappleAttached,
+	GrappleReleased,
+	Count
+};
+
+// Which compiled version of the movement tick a pawn uses
 UENUM()
-enum MovementStatus
+enum class EMovementPolicy : uint8
+{
+	// locally controlled player, reads the input component, tilts the camera
+	Player    UMETA(DisplayName = "Player"),
+	// ai or scripted pawn, reads the scripted axes, no cosmetics
+	Bot       UMETA(DisplayName = "Bot"),
+	// pawn of a remote client on the server, input comes from the replicated acceleration, no cosmetics
+	Server    UMETA(DisplayName = "Server"),
+};
+
+class AMovementMechanicsCharacter;
+
+// Runs after the character movement component has integrated the frame, the camera tilt and the latency probe
+USTRUCT()
+struct FMovementPostPhysicsTickFunction : public FTickFunction
 {
-	WALL_RUNNING   UMETA(DisplayName = "WALL_RUNNING"),
-	GRAPPLING     UMETA(DisplayName = "GRAPPLING"),
+	GENERATED_BODY()
+
+	AMovementMechanicsCharacter* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FMovementPostPhysicsTickFunction> : public TStructOpsTypeTraitsBase2<FMovementPostPhysicsTickFunction>
+{
+	enum { WithCopy = false };
 };
 
 // Declaration of the delegate that will be called when the Primary Action is triggered
 // It is declared as dynamic so it can be accessed also in Blueprints
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnUseItem);
 
+// Movement state notifications, only called on transitions so UI doesn't need to poll every frame
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWallRunBegin, TEnumAsByte<WallSideENUM>, Side);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnWallRunEnd);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGrappleCooldownStarted, float, EndTime);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnGrappleCooldownFinished);
+
 UCLASS(config=Game)
-class AMovementMechanicsCharacter : public ACharacter
+class AMovementMechanicsCharacter : public ACharacter, public IWorldPartitionStreamingSourceProvider
 {
 
 	GENERATED_BODY()
@@ -53,12 +121,15 @@ class AMovementMechanicsCharacter : public ACharacter
 		TObjectPtr<UCharacterMovementComponent> PlayerCharacterMovement;
 
 public:
-	AMovementMechanicsCharacter();
+	AMovementMechanicsCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	virtual void BeginPlay();
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 		TObjectPtr<UGrapplingHookComponent> GrappleHookComponent;
 
@@ -70,10 +141,31 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Interaction")
 	FOnUseItem OnUseItem;
 
-	// make this variable acessible by blueprints
-	// used in UI
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
+	UPROPERTY(BlueprintAssignable, Category = "Movement")
+	FOnWallRunBegin OnWallRunBegin;
+
+	UPROPERTY(BlueprintAssignable, Category = "Movement")
+	FOnWallRunEnd OnWallRunEnd;
+
+	// end time is in world seconds, UI can compute the progress from the world time
+	UPROPERTY(BlueprintAssignable, Category = "Movement")
+	FOnGrappleCooldownStarted OnGrappleCooldownStarted;
+
+	// fired by the world timer wheel when the grapple can be used again
+	UPROPERTY(BlueprintAssignable, Category = "Movement")
+	FOnGrappleCooldownFinished OnGrappleCooldownFinished;
+
+	// used in UI, kept in sync for the local player until the HUD widget uses OnGrappleCooldownStarted or GetGrappleCooldownProgress
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes, meta = (DeprecatedProperty, DeprecationMessage = "Use OnGrappleCooldownStarted or GetGrappleCooldownProgress"))
 		float TimeSinceLastGrappleDetach = 1000.0f;
+
+	// world time at which the grapple can be used again
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Attributes)
+		float GrappleCooldownEndTime = 0.0f;
+
+	// 0 when the cooldown just started, 1 when the grapple is ready
+	UFUNCTION(BlueprintPure, Category = "Movement")
+		float GetGrappleCooldownProgress() const;
 protected:
 	
 	/** Fires a projectile. */
@@ -112,8 +204,29 @@ protected:
 	
 	void Jump() override;
 	void ResetJumpState() override;
+
+	// input buffer
+	// every press goes through the buffer, the movement tick drains it and the press acts on the first
+	// frame it can within its window
+	void BufferInput(EBufferedInput Input, double PressTime);
+	// acts on the drained presses, does not drain
+	void ProcessBufferedInput();
+	// only the grapple press, the cooldown timer must not jump after the movement component moved
+	void ProcessBufferedGrapple();
+	// launch of a jump press, away from the wall when wall running or just after
+	void PerformJump();
+	FMovementInputBuffer InputBuffer;
+	// world time the last wall run ended, for the wall jump coyote time
+	float WallRunEndTime = -1000.0f;
 	void Landed(const FHitResult& Hit) override;
 
+	UFUNCTION()
+		void OnGrappleDetached();
+	// (re)schedules the end of the cooldown from GrappleCooldownEndTime
+	void ScheduleGrappleCooldownEnd();
+	void OnGrappleCooldownEnded();
+	FMovementTimerHandle GrappleCooldownTimer;
+
 	UFUNCTION()
 		void OnCompHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 	
@@ -122,18 +235,111 @@ protected:
 	bool CanSurfaceBeWallRan(const FVector ImpactNormal);
 	void FindRunDirectionAndSide(FVector wallNormal);
 	bool AreRequiredKeysDown();
-	void BeginWallRun();
-	void EndWallRun();
-	void UpdateWallRun(FHitResult hit);
+	void EnterWallRun();
+	void ExitWallRun(EMovementEvent Event);
+	// sticks to the wall every tick while wall running
+	void TickWallRun(float DeltaSeconds);
+	void UpdateWallRun(const FVector& WallNormal, float DeltaSeconds);
 	bool ShootRayToWall(FHitResult& hit);
-	void HandleCameraRotation();
+	// horizontal direction from the player to the wall it runs on
+	FVector GetWallProbeDirection() const;
+	// store the plane of the wall so following frames don't need to trace to it
+	void CacheWallPlane(const FHitResult& Hit);
+	// finds where the cached wall segment ends, at an obstacle along the run direction or where the wall stops
+	void PredictWallExit();
+	// true when the cached wall has to be confirmed with a trace this frame
+	bool ShouldRevalidateWall(float DeltaSeconds);
+	// true while the player is still close enough to the cached wall plane
+	bool IsNearCachedWall();
+	void HandleCameraRotation(float DeltaSeconds);
 
 	void ClampHorizontalVelocity();
 
 	void Tick(float deltaTime) override;
+	virtual void NotifyControllerChanged() override;
+	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode = 0) override;
+
+	// movement state machine
+	// looks up the transition for Event, runs the exit action of the current state and the enter action of the next
+	void DispatchMovementEvent(EMovementEvent Event);
+	UFUNCTION()
+		void OnGrappleStateChanged(TEnumAsByte<UGrappleState> NewState);
+
+	struct FMovementStateActions
+	{
+		void (AMovementMechanicsCharacter::*Enter)();
+		void (AMovementMechanicsCharacter::*Exit)(EMovementEvent);
+		void (AMovementMechanicsCharacter::*Update)(float);
+	};
+	static const FMovementStateActions MovementStateActions[(int32)EMovementState::Count];
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement)
+		EMovementState MovementState = EMovementState::Grounded;
+	// movement mode changes made by RestoreSnapshot are not events
+	bool bRestoringSnapshot = false;
+
+	// movement tick compiled for one input policy, see the policies in the .cpp
+	template<typename TInput>
+	void TickMovement(float DeltaSeconds);
+	struct FPlayerInputPolicy;
+	struct FScriptedInputPolicy;
+	struct FReplicatedInputPolicy;
+
+	// picks the policy from who controls the pawn
+	void SelectMovementPolicy();
+	void SetMovementPolicy(EMovementPolicy Policy);
+
+	typedef void (AMovementMechanicsCharacter::*FTickMovementFunction)(float);
+	FTickMovementFunction TickMovementFunction = &AMovementMechanicsCharacter::TickMovement<FScriptedInputPolicy>;
+	EMovementPolicy MovementPolicy = EMovementPolicy::Bot;
+	bool bMovementPolicyForced = false;
+
+	// tick order, every frame runs
+	//   character tick (input, state machine, wall run velocity) -> grapple forces -> movement component -> post physics tick (camera tilt)
+	// so the input read this frame moves the character this frame
+	friend struct FMovementPostPhysicsTickFunction;
+	FMovementPostPhysicsTickFunction PostPhysicsTickFunction;
+	void TickPostPhysics(float DeltaSeconds);
+	// only the player policy tilts the camera
+	bool bTiltCamera = false;
+	// the post physics tick only runs while there is something for it to do
+	void UpdatePostPhysicsTickEnabled();
+
+	// input latency probe
+	// remembers the frame of an input and the velocity at the time, the post physics tick counts the frames
+	// until the velocity changes in the direction of the input
+	void StartLatencyProbe(const FVector& Direction);
+	void UpdateLatencyProbe();
+	uint64 LatencyProbeFrame = 0;
+	FVector LatencyProbeVelocity;
+	FVector LatencyProbeDirection;
+	bool bLatencyProbePending = false;
+
+	// the scripted input was set by a nav link
+	bool bTraversingNavLink = false;
+
+	// simulated proxies
+	// the server copies the grapple and wall run state every tick, only sent with the other replicated properties
+	UPROPERTY(ReplicatedUsing = OnRep_ProxyState)
+		FMovementProxyState ProxyState;
+	UFUNCTION()
+		void OnRep_ProxyState();
+	void UpdateProxyState();
+
+	// streaming source names, made once so the per frame query doesn't build strings
+	FName PredictedStreamingSourceName;
+	FName GrappleStreamingSourceName;
+
+	// animation
+	// meshes of characters that are not locally controlled update at a reduced rate under load
+	void UpdateAnimationBudget();
+	bool bAnimationBudgeted = false;
 	// grapple
-	void UseGrapple();;
+	void UseGrapple();
 	void ShootGrappleRay();
+	// server side of the grapple shot, the client's hit is confirmed by a trace done as the world was at the client's time stamp
+	UFUNCTION(Server, Reliable)
+		void ServerShootGrappleRay(FVector_NetQuantize Start, FVector_NetQuantizeNormal Direction, float ClientTimeStamp, AActor* ClientHitActor, FVector_NetQuantize ClientHitLocation);
 	// Used to set the start position of the grapple based on the side
 	// of the wall that the player is wall running on
 	FVector SetGrappleLocalOffset();
@@ -157,9 +363,69 @@ public:
 	UCameraComponent* GetFirstPersonCameraComponent() const { return FirstPersonCameraComponent; }
 
 	float GetGrappleCooldown() { return GrappleCooldown; };
-	float GetTimeSinceLastGrappleDetach() { return TimeSinceLastGrappleDetach; };
+	float GetJumpBufferTime() const { return JumpBufferTime; };
+	float GetGrappleBufferTime() const { return GrappleBufferTime; };
+	float GetTimeSinceLastGrappleDetach();
+
+	// scripted input, used to drive the character when there is no player input component
+	// (simulation commandlets, bots)
+	void SetScriptedAxes(float Forward, float Right);
+	void ScriptedJump() { Jump(); };
+	void ScriptedGrapple() { UseGrapple(); };
+	// presses with their own world time stamp, to check the buffer windows, a time ahead of the world waits for it
+	void ScriptedJumpAt(double PressTime) { BufferInput(EBufferedInput::Jump, PressTime); };
+	void ScriptedGrappleAt(double PressTime) { BufferInput(EBufferedInput::Grapple, PressTime); };
+
+	// stops the policy from following the controller, used by the benchmark to compare the versions
+	void ForceMovementPolicy(EMovementPolicy Policy);
+	EMovementPolicy GetMovementPolicy() const { return MovementPolicy; };
+
+	// full state of the wall run and grapple mechanics, including the movement component and the hook,
+	// restoring and running the same input again gives the same trajectory
+	void SaveSnapshot(FMovementSnapshot& Snapshot) const;
+	void RestoreSnapshot(const FMovementSnapshot& Snapshot);
 
+	EMovementState GetMovementState() const { return MovementState; };
 
+	// the state simulated proxies extrapolate with, the proxy test sets it by hand instead of replicating it
+	const FMovementProxyState& GetProxyState() const { return ProxyState; };
+	void SetProxyState(const FMovementProxyState& State) { ProxyState = State; OnRep_ProxyState(); };
+
+	// world partition streaming ahead of the player, the controller's own source only covers where the pawn is
+	// one source where the velocity leads and one at the grapple anchor while the grapple is in use,
+	// their priority is raised while grappling
+	virtual bool GetStreamingSources(TArray<FWorldPartitionStreamingSource>& OutStreamingSources) const override;
+
+	// wall run rule shared with the nav link generator, the surface has to be close to vertical
+	static bool IsWallRunnableSurface(const FVector& ImpactNormal, float WalkableFloorAngle);
+
+	// called by the generated nav links when a bot's path reaches them, the input is released on landing
+	void StartNavLinkTraversal(EMovementTraversal Traversal, const FVector& Anchor);
+	bool IsWallRunning() const { return MovementState == EMovementState::WallRunning; };
+	int32 GetLastWallRunTraceCount() const { return LastWallRunTraceCount; };
+	// movement state read by the anim instances of both meshes when they update
+	void GetAnimSnapshot(FMovementAnimSnapshot& OutSnapshot) const;
+
+
+
+	// measure the frames between jump or move inputs and the velocity change, always on while the benchmark records
+	UPROPERTY(EditAnywhere, Category = Debug)
+		bool bProbeInputLatency = false;
+
+	// the probe gives up when the input doesn't move the character, running into a wall for example
+	UPROPERTY(EditAnywhere, Category = Debug)
+		int32 MaxInputLatencyFrames = 10;
+
+	// adds the predictive streaming sources for player controlled characters
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming)
+		bool bPredictiveStreaming = true;
+
+	// seconds of the current velocity the streaming source is moved ahead
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming)
+		float StreamingLookAheadTime = 1.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming)
+		float MaxStreamingLookAhead = 15000.0f;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
 		float WalkingSpeed = 1100;
@@ -167,23 +433,106 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
 		float GravityScale = 0.6f;
 
+	// multipliers of GravityScale and WalkingSpeed over the seconds spent wall running, constant when not set
+	// baked into lookup tables when play begins, changes to the curves after that are not seen
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Attributes)
+		UCurveFloat* WallRunGravityCurve = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Attributes)
+		UCurveFloat* WallRunSpeedCurve = nullptr;
+
+	// camera roll while wall running, in degrees
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera)
+		float MaxCameraTilt = 30.0f;
+
+	// degrees per second the camera rolls towards the tilt and back
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera)
+		float CameraTiltSpeed = 60.0f;
+
 	// make sure player is high enough to start wall run
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
 		float WallHeight = 200.0f;
 
 	float NormalGravity = 0.0f;
-	float ForwardAxis;
-	float RightAxis;
-	bool WallRunning = false;
+	float ForwardAxis = 0.0f;
+	float RightAxis = 0.0f;
+	float ScriptedForwardAxis = 0.0f;
+	float ScriptedRightAxis = 0.0f;
 
 	WallSideENUM WallSide;
 	FVector WallRunDirection;
-	
-	// status of the camera is tilted or not
-	bool CameraTilted = false;
+
+	// use the wall plane cached at the start of the wall run instead of tracing every frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
+		bool bCacheWallPlane = true;
+
+	// length of the ray shot from the player to the wall
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
+		float WallTraceLength = 200.0f;
+
+	// max time between traces that confirm the cached wall is still there
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
+		float WallValidationInterval = 0.25f;
+
+	// max distance travelled along the wall between traces, shortens the interval at high speed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
+		float WallValidationDistance = 200.0f;
+
+	// how far ahead the end of the wall is searched for when the wall run begins
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
+		float WallExitPredictionDistance = 2000.0f;
+
+	// how far before the real end of the wall the predicted one can be, smaller costs more probes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
+		float WallEdgeTolerance = 20.0f;
+
+	FBakedMovementCurve WallRunGravityTable;
+	FBakedMovementCurve WallRunSpeedTable;
+	// world time the current wall run started
+	float WallRunStartTime = 0.0f;
+
+	FVector CachedWallNormal;
+	FVector CachedWallPoint;
+	// point along the run direction where the cached wall segment is predicted to end
+	FVector PredictedWallExit;
+	// the wall stops at PredictedWallExit, past it the wall is traced every frame until it is gone
+	bool bWallEdgePredicted = false;
+	float TimeSinceWallValidation = 0.0f;
+	// number of traces done during the current wall run
+	int32 WallRunTraceCount = 0;
+	// traces done by the last wall run that ended
+	int32 LastWallRunTraceCount = 0;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
 		float GrappleCooldown = 5.0f;
 
+	// seconds a jump press waits for the character to be able to jump, landing or touching a wall
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Input)
+		float JumpBufferTime = 0.15f;
+
+	// seconds after a wall run ends in which a jump still pushes off the wall
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Input)
+		float WallJumpCoyoteTime = 0.15f;
+
+	// seconds a grapple press made during the cooldown waits for the cooldown to end
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Input)
+		float GrappleBufferTime = 0.25f;
+
+	// length of the ray shot from the camera to find the grapple target
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
+		float GrappleRayLength = 10000.0f;
+
+	// max distance between the client's grapple start and the server's camera
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
+		float MaxGrappleStartError = 200.0f;
+
+	// max time the server rewinds to validate a grapple shot
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
+		float MaxGrappleRewindTime = 0.5f;
+
+	// max distance between the client's grapple hit and the server's rewound one for the client's to be confirmed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attributes)
+		float MaxGrappleHitError = 50.0f;
+
 };
 